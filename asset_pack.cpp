@@ -0,0 +1,417 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "asset_pack.h"
+#include "content_hash.h"
+
+// The mapping of the open pack, and its index inside it.
+static MappedFile               pack = { NULL, 0, NULL, NULL };
+
+static const AssetPackEntry*    packEntries = NULL;
+static uint32_t                 packEntryCount = 0;
+
+enum AssetCheck : uint8_t
+{
+    ASSET_UNCHECKED,
+    ASSET_OK,
+    ASSET_DAMAGED
+};
+
+// Each entry's bytes are hashed the first time it is looked up, so opening a
+// pack reads only its index. Two threads may race to check the same entry,
+// which only costs a second hash.
+static std::unique_ptr<std::atomic<uint8_t>[]>  packEntryChecks;
+
+static bool readFile(std::string filename, std::vector<unsigned char>& buffer)
+{
+    std::ifstream file;
+
+    file.open(filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (file.is_open() == false)
+    {
+        return false;
+    }
+
+    buffer.resize(std::filesystem::file_size(std::filesystem::path(filename)));
+
+    file.read((char*)buffer.data(), buffer.size());
+
+    return file.good() == true || buffer.empty() == true;
+}
+
+bool writeAssetPack(std::string filename, const std::vector<std::string>& files)
+{
+    std::vector<std::string> names = files;
+
+    std::sort(names.begin(), names.end());
+
+    if (std::adjacent_find(names.begin(), names.end()) != names.end())
+    {
+        std::cout << "Asset '" << *std::adjacent_find(names.begin(), names.end()) << "' is listed twice" << std::endl;
+
+        return false;
+    }
+
+    std::vector<AssetPackEntry> entries(names.size());
+    std::vector<std::vector<unsigned char>> assets(names.size());
+
+    uint64_t offset = sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry);
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        // Room for the terminating zero.
+        if (names[i].size() >= (size_t)assetPackNameBytes)
+        {
+            std::cout << "Asset path '" << names[i] << "' is longer than " << assetPackNameBytes - 1 << " bytes" << std::endl;
+
+            return false;
+        }
+
+        if (readFile(names[i], assets[i]) == false)
+        {
+            std::cout << "Failed to read asset file " << names[i] << std::endl;
+
+            return false;
+        }
+
+        AssetPackEntry& entry = entries[i];
+
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.name, names[i].c_str(), names[i].size());
+
+        offset = (offset + assetPackAlignment - 1) / assetPackAlignment * assetPackAlignment;
+
+        entry.offset = offset;
+        entry.bytes = assets[i].size();
+        entry.hash = hashBytes(assets[i].data(), assets[i].size());
+
+        offset += entry.bytes;
+    }
+
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (file.is_open() == false)
+    {
+        std::cout << "Failed to open " << filename << " for writing" << std::endl;
+
+        return false;
+    }
+
+    AssetPackHeader header = { assetPackMagic, assetPackVersion, (uint32_t)entries.size(), 0 };
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)entries.data(), entries.size() * sizeof(AssetPackEntry));
+
+    uint64_t written = sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry);
+
+    const char padding[assetPackAlignment] = {};
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        file.write(padding, entries[i].offset - written);
+        file.write((const char*)assets[i].data(), assets[i].size());
+
+        written = entries[i].offset + entries[i].bytes;
+    }
+
+    if (file.good() == false)
+    {
+        std::cout << "Failed to write " << filename << std::endl;
+
+        return false;
+    }
+
+    std::cout << "Packed " << entries.size() << " assets, " << written << " bytes, into " << filename << std::endl;
+
+    return true;
+}
+
+bool mapFile(std::string filename, MappedFile& file)
+{
+    file.data = NULL;
+    file.bytes = 0;
+    file.file = NULL;
+    file.mapping = NULL;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    file.file = handle;
+
+    LARGE_INTEGER size;
+
+    if (GetFileSizeEx(handle, &size) == FALSE || size.QuadPart == 0)
+    {
+        unmapFile(file);
+
+        return false;
+    }
+
+    file.mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (file.mapping != NULL)
+    {
+        file.data = (const unsigned char*)MapViewOfFile(file.mapping, FILE_MAP_READ, 0, 0, 0);
+        file.bytes = (size_t)size.QuadPart;
+    }
+
+    if (file.data == NULL)
+    {
+        unmapFile(file);
+
+        return false;
+    }
+
+    return true;
+#else
+    int descriptor = open(filename.c_str(), O_RDONLY);
+
+    if (descriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+
+    if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+    {
+        close(descriptor);
+
+        return false;
+    }
+
+    void* mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+    // The mapping holds its own reference to the file.
+    close(descriptor);
+
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    file.data = (const unsigned char*)mapping;
+    file.bytes = status.st_size;
+
+    return true;
+#endif
+}
+
+void unmapFile(MappedFile& file)
+{
+#ifdef _WIN32
+    if (file.data != NULL)
+    {
+        UnmapViewOfFile(file.data);
+    }
+
+    if (file.mapping != NULL)
+    {
+        CloseHandle(file.mapping);
+    }
+
+    if (file.file != NULL)
+    {
+        CloseHandle(file.file);
+    }
+#else
+    if (file.data != NULL)
+    {
+        munmap((void*)file.data, file.bytes);
+    }
+#endif
+
+    file.data = NULL;
+    file.bytes = 0;
+    file.file = NULL;
+    file.mapping = NULL;
+}
+
+bool openAssetPack(std::string filename)
+{
+    closeAssetPack();
+
+    if (mapFile(filename, pack) == false)
+    {
+        std::cout << "Failed to map asset pack " << filename << std::endl;
+
+        closeAssetPack();
+
+        return false;
+    }
+
+    const AssetPackHeader* header = (const AssetPackHeader*)pack.data;
+
+    if (pack.bytes < sizeof(AssetPackHeader) || header->magic != assetPackMagic || header->version != assetPackVersion)
+    {
+        std::cout << filename << " is not a version " << assetPackVersion << " asset pack" << std::endl;
+
+        closeAssetPack();
+
+        return false;
+    }
+
+    uint64_t indexEnd = sizeof(AssetPackHeader) + (uint64_t)header->entryCount * sizeof(AssetPackEntry);
+
+    bool valid = (indexEnd <= pack.bytes);
+
+    const AssetPackEntry* entries = (const AssetPackEntry*)(pack.data + sizeof(AssetPackHeader));
+
+    // Lookups trust the index from here on, so every entry has to point inside the pack.
+    for (uint32_t i = 0; i < header->entryCount && valid == true; i++)
+    {
+        const AssetPackEntry& entry = entries[i];
+
+        valid &= (entry.name[assetPackNameBytes - 1] == 0);
+        valid &= (entry.offset >= indexEnd && entry.offset <= pack.bytes && entry.bytes <= pack.bytes - entry.offset);
+        valid &= (i == 0 || strcmp(entries[i - 1].name, entry.name) < 0);
+    }
+
+    if (valid == false)
+    {
+        std::cout << "Asset pack " << filename << " has a damaged index" << std::endl;
+
+        closeAssetPack();
+
+        return false;
+    }
+
+    packEntryChecks.reset(new std::atomic<uint8_t>[header->entryCount]);
+
+    for (uint32_t i = 0; i < header->entryCount; i++)
+    {
+        packEntryChecks[i].store(ASSET_UNCHECKED, std::memory_order_relaxed);
+    }
+
+    packEntries = entries;
+    packEntryCount = header->entryCount;
+
+    return true;
+}
+
+void closeAssetPack()
+{
+    unmapFile(pack);
+
+    packEntries = NULL;
+    packEntryCount = 0;
+
+    packEntryChecks.reset();
+}
+
+// The index entry of the asset packed from path name, or NULL. A damaged
+// entry is left out, so the asset is read from disk. Its bytes are checked the
+// first time it is found.
+static const AssetPackEntry* findAssetEntry(const std::string& name)
+{
+    if (packEntries == NULL)
+    {
+        return NULL;
+    }
+
+    const AssetPackEntry* end = packEntries + packEntryCount;
+
+    const AssetPackEntry* entry = std::lower_bound(packEntries, end, name, [](const AssetPackEntry& entry, const std::string& name) { return strcmp(entry.name, name.c_str()) < 0; });
+
+    if (entry == end || name != entry->name)
+    {
+        return NULL;
+    }
+
+    std::atomic<uint8_t>& check = packEntryChecks[entry - packEntries];
+
+    if (check.load(std::memory_order_relaxed) == ASSET_UNCHECKED)
+    {
+        bool damaged = (hashBytes(pack.data + entry->offset, entry->bytes) != entry->hash);
+
+        if (damaged == true)
+        {
+            std::cout << "Asset '" << entry->name << "' doesn't match its hash in the pack" << std::endl;
+        }
+
+        check.store(damaged ? ASSET_DAMAGED : ASSET_OK, std::memory_order_relaxed);
+    }
+
+    if (check.load(std::memory_order_relaxed) == ASSET_DAMAGED)
+    {
+        return NULL;
+    }
+
+    return entry;
+}
+
+bool findAsset(std::string name, AssetSpan& span)
+{
+    const AssetPackEntry* entry = findAssetEntry(name);
+
+    if (entry == NULL)
+    {
+        return false;
+    }
+
+    span.data = pack.data + entry->offset;
+    span.bytes = entry->bytes;
+
+    return true;
+}
+
+bool findAssetHash(std::string name, uint64_t& hash)
+{
+    const AssetPackEntry* entry = findAssetEntry(name);
+
+    if (entry == NULL)
+    {
+        return false;
+    }
+
+    hash = entry->hash;
+
+    return true;
+}
+
+bool readAsset(std::string name, std::vector<unsigned char>& buffer, AssetSpan& span)
+{
+    if (findAsset(name, span) == true)
+    {
+        return true;
+    }
+
+    if (readFile(name, buffer) == false)
+    {
+        return false;
+    }
+
+    span.data = buffer.data();
+    span.bytes = buffer.size();
+
+    return true;
+}
+
+bool assetExists(std::string name)
+{
+    return findAssetEntry(name) != NULL || std::filesystem::exists(std::filesystem::path(name)) == true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A pack is an AssetPackHeader, entryCount AssetPackEntry sorted by name, then
+// the assets' bytes, each at an offset that is a multiple of
+// assetPackAlignment. Integers are in the byte order of the machine that
+// wrote it.
+const uint32_t assetPackMagic = 0x50414254;
+const uint32_t assetPackVersion = 1;
+
+const int assetPackNameBytes = 64;
+
+const uint64_t assetPackAlignment = 16;
+
+struct AssetPackHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    entryCount;
+    uint32_t    reserved;
+};
+
+struct AssetPackEntry
+{
+    // The path the asset was packed from, zero padded. Looked up by that path.
+    char        name[assetPackNameBytes];
+
+    // From the start of the pack.
+    uint64_t    offset;
+    uint64_t    bytes;
+
+    // hashBytes() of the asset, checked the first time it is looked up.
+    uint64_t    hash;
+};
+
+// Bytes of an asset inside the mapped pack, valid until closeAssetPack().
+struct AssetSpan
+{
+    const unsigned char*    data;
+    size_t                  bytes;
+};
+
+// A whole file mapped read-only.
+struct MappedFile
+{
+    const unsigned char*    data;
+    size_t                  bytes;
+
+    // The file and mapping handles on Windows. Unused elsewhere.
+    void*                   file;
+    void*                   mapping;
+};
+
+// Map filename, which must not be empty. False if it can't be.
+bool mapFile(std::string filename, MappedFile& file);
+
+void unmapFile(MappedFile& file);
+
+// Pack files into filename, each named by its path as given. Returns false
+// if a file can't be read, a path is too long, or two are the same.
+bool writeAssetPack(std::string filename, const std::vector<std::string>& files);
+
+// Map filename and check its header and index. Assets are read from it
+// instead of their own files until closeAssetPack(), except those that don't
+// match their hash. Only the index is read here; the assets are paged in as
+// they are used.
+bool openAssetPack(std::string filename);
+
+void closeAssetPack();
+
+// Find the asset packed from path name in the open pack, with a binary search
+// of its index, and hash its bytes the first time. False when there is no
+// pack, the asset isn't in it, or its bytes don't match their hash. Safe to call from any thread while the pack
+// is open.
+bool findAsset(std::string name, AssetSpan& span);
+
+// The hash the open pack's index has for the asset packed from path name,
+// without reading its bytes. False as for findAsset().
+bool findAssetHash(std::string name, uint64_t& hash);
+
+// An asset from the open pack, or else the file at name read into buffer.
+bool readAsset(std::string name, std::vector<unsigned char>& buffer, AssetSpan& span);
+
+// In the open pack or on disk. Only looks at the index, not the asset's bytes.
+bool assetExists(std::string name);
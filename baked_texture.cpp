@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/glu.h>
+
+#include "asset_pack.h"
+#include "baked_texture.h"
+#include "block_compression.h"
+#include "content_hash.h"
+#include "mipmaps.h"
+#include "testbed.h"
+
+bool            bakedTextures = false;
+
+TextureCompression bakedTextureCompression = TEXTURE_COMPRESSION_NONE;
+
+bool setBakedTextureCompression(std::string name)
+{
+    if (name == "none")
+    {
+        bakedTextureCompression = TEXTURE_COMPRESSION_NONE;
+    }
+    else if (name == "bc1")
+    {
+        bakedTextureCompression = TEXTURE_COMPRESSION_BC1;
+    }
+    else if (name == "bc3")
+    {
+        bakedTextureCompression = TEXTURE_COMPRESSION_BC3;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+std::string getBakedTexturePath(std::string imageFilename)
+{
+    size_t slash = imageFilename.find_last_of("/\\");
+    size_t dot = imageFilename.find_last_of('.');
+
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+    {
+        imageFilename.resize(dot);
+    }
+
+    return imageFilename + bakedTextureExtension;
+}
+
+// Bytes of a width x height level in the header's format, or 0 if the format isn't one we bake.
+static uint64_t getBakedLevelBytes(const BakedTextureHeader& header, uint32_t width, uint32_t height)
+{
+    if (header.format != GL_RGBA || header.type != GL_UNSIGNED_BYTE)
+    {
+        return 0;
+    }
+
+    TextureCompression compression = getTextureCompression(header.internalFormat);
+
+    if (compression == TEXTURE_COMPRESSION_NONE && header.internalFormat != GL_RGBA8)
+    {
+        return 0;
+    }
+
+    return getCompressedLevelBytes(compression, width, height);
+}
+
+// Whether any pixel of level 0 isn't fully opaque.
+static bool imageHasAlpha(const DecodedImage& image)
+{
+    size_t pixelCount = (size_t)image.width * image.height;
+
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        if (image.pixels[i * 4 + 3] != 255)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool bakeTexture(std::string imageFilename)
+{
+    DecodedImage image;
+
+    if (decodeImageFile(imageFilename, image) == false)
+    {
+        return false;
+    }
+
+    if (textureMipmaps == true)
+    {
+        generateMipmaps(image, true);
+    }
+
+    std::string bakedFilename = getBakedTexturePath(imageFilename);
+
+    if (image.levelCount > bakedTextureMaxLevels)
+    {
+        std::cout << imageFilename << " has more than " << bakedTextureMaxLevels << " levels to bake" << std::endl;
+
+        return false;
+    }
+
+    TextureCompression compression = bakedTextureCompression;
+
+    // BC1 is baked opaque, which would fill in a sprite's transparent parts.
+    if (compression == TEXTURE_COMPRESSION_BC1 && imageHasAlpha(image) == true)
+    {
+        std::cout << imageFilename << " has alpha, which BC1 drops, so it is baked as BC3" << std::endl;
+
+        compression = TEXTURE_COMPRESSION_BC3;
+    }
+
+    BakedTextureHeader header = { bakedTextureMagic, bakedTextureVersion, getCompressedInternalFormat(compression), GL_RGBA, GL_UNSIGNED_BYTE, (uint32_t)image.width, (uint32_t)image.height, (uint32_t)image.levelCount };
+
+    BakedTextureLevel levels[bakedTextureMaxLevels];
+
+    uint64_t offset = sizeof(header) + image.levelCount * sizeof(BakedTextureLevel);
+
+    for (int i = 0; i < image.levelCount; i++)
+    {
+        levels[i].width = getMipLevelSize(image.width, i);
+        levels[i].height = getMipLevelSize(image.height, i);
+        levels[i].offset = (offset + bakedTextureAlignment - 1) / bakedTextureAlignment * bakedTextureAlignment;
+        levels[i].bytes = getCompressedLevelBytes(compression, levels[i].width, levels[i].height);
+
+        offset = levels[i].offset + levels[i].bytes;
+    }
+
+    std::ofstream file(bakedFilename.c_str(), std::ios::out | std::ios::binary);
+
+    if (file.is_open() == false)
+    {
+        std::cout << "Failed to open " << bakedFilename << " for writing" << std::endl;
+
+        return false;
+    }
+
+    const char padding[bakedTextureAlignment] = {};
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)levels, image.levelCount * sizeof(BakedTextureLevel));
+
+    uint64_t written = sizeof(header) + image.levelCount * sizeof(BakedTextureLevel);
+
+    std::vector<unsigned char> blocks;
+
+    for (int i = 0; i < image.levelCount; i++)
+    {
+        blocks.resize(levels[i].bytes);
+
+        compressTextureLevel(compression, image.pixels.data() + getMipLevelOffset(image.width, image.height, i), levels[i].width, levels[i].height, blocks.data(), true);
+
+        file.write(padding, levels[i].offset - written);
+        file.write((const char*)blocks.data(), blocks.size());
+
+        written = levels[i].offset + levels[i].bytes;
+    }
+
+    if (file.good() == false)
+    {
+        std::cout << "Failed to write " << bakedFilename << std::endl;
+
+        return false;
+    }
+
+    std::cout << "Baked " << imageFilename << " into " << bakedFilename << ", " << image.width << "x" << image.height << ", " << image.levelCount << " levels of " << textureCompressionName(compression) << std::endl;
+
+    return true;
+}
+
+bool bakedTextureAvailable(std::string imageFilename)
+{
+    return bakedTextures == true && assetExists(getBakedTexturePath(imageFilename)) == true;
+}
+
+// Check that the header and level table describe a texture whose levels all lie inside bytes.
+static bool validateBakedTexture(const unsigned char* data, size_t bytes)
+{
+    const BakedTextureHeader* header = (const BakedTextureHeader*)data;
+
+    if (bytes < sizeof(BakedTextureHeader) || header->magic != bakedTextureMagic || header->version != bakedTextureVersion)
+    {
+        return false;
+    }
+
+    if (header->width == 0 || header->height == 0 || header->levelCount == 0 || header->levelCount > (uint32_t)bakedTextureMaxLevels)
+    {
+        return false;
+    }
+
+    uint64_t tableEnd = sizeof(BakedTextureHeader) + header->levelCount * sizeof(BakedTextureLevel);
+
+    if (tableEnd > bytes)
+    {
+        return false;
+    }
+
+    const BakedTextureLevel* levels = (const BakedTextureLevel*)(data + sizeof(BakedTextureHeader));
+
+    for (uint32_t i = 0; i < header->levelCount; i++)
+    {
+        const BakedTextureLevel& level = levels[i];
+
+        uint32_t width = std::max(1u, header->width >> i);
+        uint32_t height = std::max(1u, header->height >> i);
+
+        uint64_t levelBytes = getBakedLevelBytes(*header, width, height);
+
+        if (level.width != width || level.height != height || levelBytes == 0 || level.bytes != levelBytes)
+        {
+            return false;
+        }
+
+        if (level.offset < tableEnd || level.offset > bytes || level.bytes > bytes - level.offset)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint64_t getBakedTextureBytes(const unsigned char* data, size_t bytes)
+{
+    if (validateBakedTexture(data, bytes) == false)
+    {
+        return 0;
+    }
+
+    const BakedTextureHeader& header = *(const BakedTextureHeader*)data;
+
+    const BakedTextureLevel* levels = (const BakedTextureLevel*)(data + sizeof(BakedTextureHeader));
+
+    uint64_t textureBytes = 0;
+
+    for (uint32_t i = 0; i < header.levelCount; i++)
+    {
+        textureBytes += levels[i].bytes;
+    }
+
+    return textureBytes;
+}
+
+static bool uploadBakedTexture(const unsigned char* data, GLuint& textureId, uint32_t level)
+{
+    const BakedTextureHeader& header = *(const BakedTextureHeader*)data;
+
+    const BakedTextureLevel* levels = (const BakedTextureLevel*)(data + sizeof(BakedTextureHeader));
+
+    TextureCompression compression = getTextureCompression(header.internalFormat);
+
+    if (compression != TEXTURE_COMPRESSION_NONE && GLEW_EXT_texture_compression_s3tc == false)
+    {
+        std::cout << "The GL has no S3TC, so it can't load " << textureCompressionName(compression) << " textures" << std::endl;
+
+        return false;
+    }
+
+    glGenTextures(1, &textureId);
+
+    RETURN_IF_GL_ERROR("glGenTextures");
+
+    glActiveTexture(GL_TEXTURE0 + level);
+
+    glBindTexture(GL_TEXTURE_2D, textureId);
+
+    // Immutable storage lets the driver place every level at once, instead of
+    // guessing at the chain as each glTexImage2D() arrives.
+    bool immutable = GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+
+    if (immutable == true)
+    {
+        glTexStorage2D(GL_TEXTURE_2D, header.levelCount, header.internalFormat, header.width, header.height);
+    }
+
+    for (uint32_t i = 0; i < header.levelCount; i++)
+    {
+        const BakedTextureLevel& bakedLevel = levels[i];
+
+        if (compression != TEXTURE_COMPRESSION_NONE)
+        {
+            if (immutable == true)
+            {
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, bakedLevel.width, bakedLevel.height, header.internalFormat, bakedLevel.bytes, data + bakedLevel.offset);
+            }
+            else
+            {
+                glCompressedTexImage2D(GL_TEXTURE_2D, i, header.internalFormat, bakedLevel.width, bakedLevel.height, 0, bakedLevel.bytes, data + bakedLevel.offset);
+            }
+        }
+        else if (immutable == true)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, bakedLevel.width, bakedLevel.height, header.format, header.type, data + bakedLevel.offset);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, i, header.internalFormat, bakedLevel.width, bakedLevel.height, 0, header.format, header.type, data + bakedLevel.offset);
+        }
+    }
+
+    setImageTextureParameters(header.levelCount);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLenum error = glGetError();
+
+    if (error != GL_NO_ERROR)
+    {
+        std::cout << "Function glTexSubImage2D failed with error: " << gluErrorString(error) << std::endl;
+
+        // The caller falls back to decoding the image, into a texture of its own.
+        glDeleteTextures(1, &textureId);
+
+        textureId = 0;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool loadBakedTexture(std::string filename, GLuint& textureId, uint32_t level, LoadedTextureInfo* info)
+{
+    MappedFile file = { NULL, 0, NULL, NULL };
+
+    AssetSpan span;
+
+    if (findAsset(filename, span) == false)
+    {
+        if (mapFile(filename, file) == false)
+        {
+            std::cout << "Failed to map baked texture " << filename << std::endl;
+
+            return false;
+        }
+
+        span.data = file.data;
+        span.bytes = file.bytes;
+    }
+
+    bool ok = validateBakedTexture(span.data, span.bytes);
+
+    if (ok == false)
+    {
+        std::cout << filename << " is not a version " << bakedTextureVersion << " baked texture" << std::endl;
+    }
+    else
+    {
+        // The GL has copied the levels out by the time the upload returns, so the mapping can go.
+        ok = uploadBakedTexture(span.data, textureId, level);
+    }
+
+    if (ok == true && info != NULL)
+    {
+        info->fileHash = hashBytes(span.data, span.bytes);
+        info->bytes = getBakedTextureBytes(span.data, span.bytes);
+    }
+
+    unmapFile(file);
+
+    return ok;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "block_compression.h"
+
+struct LoadedTextureInfo;
+
+// A baked texture is a BakedTextureHeader, levelCount BakedTextureLevel, then
+// each level's pixels at its offset, in the layout the GL takes them in, so
+// loading one is a map and an upload with no decode. Levels are RGBA8 or
+// blocks of one of the TextureCompression formats. Integers are in the byte
+// order of the machine that baked it.
+const uint32_t bakedTextureMagic = 0x58544254;
+const uint32_t bakedTextureVersion = 1;
+
+const int bakedTextureMaxLevels = 16;
+
+const uint64_t bakedTextureAlignment = 16;
+
+// Replaces the image's extension.
+const char* const bakedTextureExtension = ".btex";
+
+struct BakedTextureHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+
+    // As glTexStorage2D() and glTexSubImage2D() take them.
+    uint32_t    internalFormat;
+    uint32_t    format;
+    uint32_t    type;
+
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    levelCount;
+};
+
+// Level n is max(1, width >> n) by max(1, height >> n).
+struct BakedTextureLevel
+{
+    uint32_t    width;
+    uint32_t    height;
+
+    // From the start of the file.
+    uint64_t    offset;
+    uint64_t    bytes;
+};
+
+// When set, images with a baked copy beside them, or in the asset pack, are
+// loaded from it instead of being decoded.
+extern bool            bakedTextures;
+
+// The format bakeTexture() writes levels in.
+extern TextureCompression bakedTextureCompression;
+
+// Set bakedTextureCompression by name: none, bc1 or bc3. False for any other.
+bool setBakedTextureCompression(std::string name);
+
+// Where the baked copy of imageFilename goes: its path with bakedTextureExtension.
+std::string getBakedTexturePath(std::string imageFilename);
+
+// Decode imageFilename and write it to getBakedTexturePath(imageFilename) in
+// bakedTextureCompression, or BC3 for BC1 if the image isn't opaque, with its
+// full mip chain when textureMipmaps is set, else as a single level. Mips and
+// blocks are split over the job threads, so call it from thread 0 after
+// initJobSystem().
+bool bakeTexture(std::string imageFilename);
+
+// With bakedTextures set, whether imageFilename has a baked copy to load.
+bool bakedTextureAvailable(std::string imageFilename);
+
+// GPU bytes of every level of the baked texture in data, 0 if it isn't a valid one.
+uint64_t getBakedTextureBytes(const unsigned char* data, size_t bytes);
+
+// Map a baked texture, from the asset pack if it is there, check its header
+// and upload every level into a new texture, as immutable storage where the
+// GL has it. Compressed textures fail where the GL has no S3TC. Bound to
+// texture unit level while uploading, as with loadImageIntoTexture(), which
+// info is filled as for. On failure no texture is left behind.
+bool loadBakedTexture(std::string filename, GLuint& textureId, uint32_t level, LoadedTextureInfo* info = NULL);
@@ -0,0 +1,798 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <GL/glew.h>
+
+#include "benchmark.h"
+#include "camera.h"
+#include "frame_arena.h"
+#include "gpu_buffer_arena.h"
+#include "job_system.h"
+#include "profiler.h"
+#include "quad_groups.h"
+#include "quad_store.h"
+#include "quad_transform.h"
+#include "render_thread.h"
+#include "screen.h"
+#include "testbed.h"
+#include "texture_loader.h"
+
+// Timings of one measured frame, in milliseconds.
+struct FrameSample
+{
+    double      frameMs;
+    double      buildMs;
+
+    // The path's commands, timed on the thread that runs them, so it covers
+    // the same work as uploadMs with or without a render thread.
+    std::chrono::steady_clock::time_point renderStart;
+    double      renderMs;
+
+    double      uploadMs;
+    double      presentMs;
+    uint64_t    uploadBytes;
+    uint64_t    skippedBytes;
+    uint64_t    fenceWaits;
+};
+
+struct TimingSummary
+{
+    double      mean;
+    double      min;
+    double      p50;
+    double      p90;
+    double      p99;
+    double      max;
+};
+
+struct BenchmarkResult
+{
+    std::string     pathName;
+    int             quadCount;
+    int             frames;
+    TimingSummary   frameMs;
+    TimingSummary   buildMs;
+    TimingSummary   drawMs;
+    TimingSummary   presentMs;
+    double          uploadBytesPerFrame;
+    double          skippedBytesPerFrame;
+    double          uploadMsPerFrame;
+    double          uploadBytesPerSecond;
+    uint64_t        uploadFenceWaits;
+    uint64_t        peakMemoryBytes;
+
+    // Backing buffers of the GPU buffer arena at the end of the run.
+    uint64_t        gpuBufferBytes;
+
+    // Quads the last scene build kept and culled, with --cull.
+    uint64_t        visibleQuads;
+    uint64_t        culledQuads;
+
+    // Only filled in with --profile.
+    std::vector<ProfileStats>   scopes;
+};
+
+void parseBenchmarkArgs(int argc, char* argv[], BenchmarkSettings& settings)
+{
+    settings.enabled = false;
+    settings.quadCounts = { 100, 1000, 10000, 100000, 1000000 };
+    settings.seed = 1;
+    settings.warmupFrames = 10;
+    settings.frames = 100;
+    settings.groupSize = 8;
+    settings.minScale = 0.25f;
+    settings.maxScale = 2.0f;
+    settings.maxRotation = 180.0f;
+    settings.worldScale = 1.0f;
+    settings.panPixels = 0.0f;
+    settings.mutatePercent = 0.0f;
+    settings.groupChangeFrames = 0;
+    settings.jsonFilename.clear();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--benchmark") == 0)
+        {
+            settings.enabled = true;
+        }
+        else if (strcmp(argv[i], "--quads") == 0 && i + 1 < argc)
+        {
+            settings.quadCounts.clear();
+
+            std::stringstream counts(argv[++i]);
+            std::string count;
+
+            while (std::getline(counts, count, ','))
+            {
+                settings.quadCounts.push_back(atoi(count.c_str()));
+            }
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            settings.seed = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            settings.warmupFrames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--group-size") == 0 && i + 1 < argc)
+        {
+            settings.groupSize = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+        {
+            sscanf(argv[++i], "%f,%f", &settings.minScale, &settings.maxScale);
+        }
+        else if (strcmp(argv[i], "--rotation") == 0 && i + 1 < argc)
+        {
+            settings.maxRotation = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--world") == 0 && i + 1 < argc)
+        {
+            settings.worldScale = std::max(1.0f, (float)atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--pan") == 0 && i + 1 < argc)
+        {
+            settings.panPixels = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--mutate") == 0 && i + 1 < argc)
+        {
+            settings.mutatePercent = std::min(100.0f, std::max(0.0f, (float)atof(argv[++i])));
+        }
+        else if (strcmp(argv[i], "--group-changes") == 0 && i + 1 < argc)
+        {
+            settings.groupChangeFrames = std::max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            settings.jsonFilename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            // Read here rather than from frameLimit, which headless mode defaults to 300.
+            settings.frames = std::max(1, atoi(argv[++i]));
+        }
+    }
+}
+
+// A float in [0, 1) from the raw engine output. The std distributions are
+// implementation defined, which would make scenes differ between compilers.
+static float unitFloat(std::mt19937& random)
+{
+    return (random() >> 8) * (1.0f / 16777216.0f);
+}
+
+// A quad's place, rotation and scale, but not its group.
+static void randomQuad(std::mt19937& random, const BenchmarkSettings& settings, QuadParams& quad)
+{
+    // Centers anywhere in the world, which the default camera centers on the screen.
+    quad.x = (unitFloat(random) - 0.5f) * screenWidth * settings.worldScale;
+    quad.y = (unitFloat(random) - 0.5f) * screenHeight * settings.worldScale;
+
+    quad.rotationDegrees = (unitFloat(random) * 2.0f - 1.0f) * settings.maxRotation;
+
+    quad.scale = settings.minScale + unitFloat(random) * (settings.maxScale - settings.minScale);
+}
+
+void generateScene(std::vector<QuadParams>& quads, int quadCount, const BenchmarkSettings& settings)
+{
+    std::mt19937 random(settings.seed);
+
+    quads.resize(quadCount);
+
+    for (int i = 0; i < quadCount; i++)
+    {
+        QuadParams& quad = quads[i];
+
+        randomQuad(random, settings, quad);
+
+        quad.newGroup = (i == 0) || (random() % settings.groupSize == 0);
+    }
+}
+
+static TimingSummary summarize(std::vector<double> values)
+{
+    TimingSummary summary = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+    if (values.empty() == true)
+    {
+        return summary;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    double total = 0.0;
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        total += values[i];
+    }
+
+    // Nearest rank percentile.
+    auto percentile = [&values](double p)
+    {
+        size_t rank = (size_t)(p * (values.size() - 1) + 0.5);
+
+        return values[rank];
+    };
+
+    summary.mean = total / values.size();
+    summary.min = values.front();
+    summary.p50 = percentile(0.50);
+    summary.p90 = percentile(0.90);
+    summary.p99 = percentile(0.99);
+    summary.max = values.back();
+
+    return summary;
+}
+
+static uint64_t getPeakMemoryBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == FALSE)
+    {
+        return 0;
+    }
+
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+
+    // Linux reports kilobytes.
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+static double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// The upload statistics belong to the thread with the context, so they are reset
+// and read by commands recorded around each frame.
+static void resetUploadStats(void*)
+{
+    uploadStats = UploadStats{ 0, 0, 0.0, 0, 0 };
+}
+
+static void storeUploadStats(void* data)
+{
+    FrameSample& sample = *static_cast<FrameSample*>(data);
+
+    sample.uploadMs = uploadStats.milliseconds;
+    sample.uploadBytes = uploadStats.bytes;
+    sample.skippedBytes = uploadStats.skippedBytes;
+    sample.fenceWaits = uploadStats.fenceWaits;
+}
+
+static void startRenderTimer(void* data)
+{
+    FrameSample& sample = *static_cast<FrameSample*>(data);
+
+    sample.renderStart = std::chrono::steady_clock::now();
+}
+
+static void storeRenderTime(void* data)
+{
+    FrameSample& sample = *static_cast<FrameSample*>(data);
+
+    sample.renderMs = millisecondsBetween(sample.renderStart, std::chrono::steady_clock::now());
+}
+
+static void resetProfilerCall(void*)
+{
+    resetProfiler();
+}
+
+// Change settings.mutatePercent of the retained scene's quads: every other
+// one picked moves, the rest are destroyed and created again after the last
+// quad. The holes are compacted before the frame's upload.
+static void mutateScene(QuadStore& store, std::vector<QuadHandle>& handles, std::mt19937& random, const BenchmarkSettings& settings)
+{
+    if (handles.empty() == true)
+    {
+        return;
+    }
+
+    int count = (int)(handles.size() * settings.mutatePercent / 100.0f);
+
+    const ColorRgba color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    for (int i = 0; i < count; i++)
+    {
+        QuadHandle& handle = handles[random() % handles.size()];
+
+        QuadParams quad;
+
+        randomQuad(random, settings, quad);
+
+        float size = (int)(50 * quad.scale);
+
+        if (i % 2 == 0)
+        {
+            updateQuad(store, handle, quad.x, quad.y, size, size, quad.rotationDegrees, color);
+        }
+        else
+        {
+            destroyQuad(store, handle);
+
+            handle = createQuad(store, quad.x, quad.y, size, size, quad.rotationDegrees, color);
+        }
+    }
+
+    compactQuadStore(store);
+}
+
+// Groups raised at once before the draw order is reset.
+const int benchmarkRaisedGroups = 8;
+
+// Flip one random group's visibility and raise another over the rest, the
+// way a highlight would. Once benchmarkRaisedGroups are raised, the order
+// starts over.
+static void changeQuadGroups(Shader& shader, std::mt19937& random)
+{
+    int groupCount = getQuadGroupCount(shader);
+
+    if (groupCount == 0)
+    {
+        return;
+    }
+
+    int hidden = random() % groupCount;
+
+    setQuadGroupVisible(shader, hidden, quadGroupVisible(shader, hidden) == false);
+
+    if (shader.groupDrawOrder.size() >= (size_t)benchmarkRaisedGroups)
+    {
+        setQuadGroupDrawOrder(shader, std::vector<int>());
+    }
+
+    raiseQuadGroup(shader, random() % groupCount);
+}
+
+static bool benchmarkPath(RenderPath& path, int quadCount, const BenchmarkSettings& settings, BenchmarkResult& result, bool& quit)
+{
+    std::vector<QuadParams> quads;
+
+    generateScene(quads, quadCount, settings);
+
+    benchmarkScene = &quads;
+
+    // Handles of the scene's quads, with --mutate.
+    QuadStore store;
+
+    std::vector<QuadHandle> handles;
+
+    std::mt19937 mutateRandom(settings.seed + 1);
+
+    bool mutating = false;
+
+    std::mt19937 groupRandom(settings.seed + 2);
+
+    // Every run starts from the same view, however far the last one panned.
+    Camera2D startCamera = getCamera();
+
+    if (path.init() == false)
+    {
+        std::cout << "Render path '" << path.name << "' initialization failed" << std::endl;
+
+        path.shutdown();
+
+        benchmarkScene = NULL;
+        benchmarkSceneShader = NULL;
+
+        return false;
+    }
+
+    // Frames are timed with the path's real textures, not their placeholders.
+    finishTextureLoads();
+
+    // Sized up front: the render thread fills in the upload statistics of a frame after it is recorded.
+    std::vector<FrameSample> samples(settings.frames);
+
+    FrameSample warmupSample;
+
+    int measuredFrames = 0;
+
+    if (startRenderThread() == false)
+    {
+        path.shutdown();
+
+        benchmarkScene = NULL;
+        benchmarkSceneShader = NULL;
+
+        return false;
+    }
+
+    for (int frame = 0; frame < settings.warmupFrames + settings.frames; frame++)
+    {
+        if (pollQuitEvent() == true)
+        {
+            quit = true;
+
+            break;
+        }
+
+        resetFrameArena();
+
+        // The profiler restarts with the measured frames, so give it a few to settle too.
+        bool checkAllocations = (frame >= settings.warmupFrames + allocationCheckWarmupFrames && profilerTracing() == false);
+
+        beginAllocationCheck();
+
+        FrameSample& sample = (frame >= settings.warmupFrames) ? samples[frame - settings.warmupFrames] : warmupSample;
+
+        // With a render thread, a frame includes waiting for it to draw the frame before last.
+        std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+
+        beginRenderCommands();
+
+        // Warmup frames stay out of the profile like they stay out of the samples.
+        if (frame == settings.warmupFrames)
+        {
+            recordCall(resetProfilerCall, NULL);
+        }
+
+        recordCall(resetUploadStats, NULL);
+
+        recordBeginProfilerFrame();
+
+        recordBindFramebuffer(screenFrameBufferId);
+
+        recordClear(0.0f, 0.0f, 0.0f, 0.0f, GL_COLOR_BUFFER_BIT);
+
+        std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+
+        beginMainThreadProfileScope("buildScene");
+
+        // Only the view matrix changes, the quads stay where they are in the world.
+        if (settings.panPixels != 0.0f)
+        {
+            panCamera(settings.panPixels, 0.0f);
+        }
+
+        // Retained quads stay in the shader, so a static scene is only built once.
+        if (retainedQuads == false || frame == 0)
+        {
+            cullStats = CullStats{ 0, 0 };
+
+            path.buildScene();
+
+            result.visibleQuads = cullStats.visibleQuads;
+            result.culledQuads = cullStats.culledQuads;
+
+            mutating = retainedQuads == true && settings.mutatePercent > 0.0f && benchmarkSceneShader != NULL;
+
+            if (mutating == true)
+            {
+                initQuadStore(store, *benchmarkSceneShader);
+
+                // Quads already in the shader get handles 0 .. n - 1.
+                handles.resize(getQuadCount(*benchmarkSceneShader));
+
+                for (size_t i = 0; i < handles.size(); i++)
+                {
+                    handles[i] = i;
+                }
+            }
+        }
+        else if (mutating == true)
+        {
+            mutateScene(store, handles, mutateRandom, settings);
+        }
+
+        if (settings.groupChangeFrames > 0 && benchmarkSceneShader != NULL)
+        {
+            Shader& shader = *benchmarkSceneShader;
+
+            // Sized up front, so the changes don't allocate in measured frames.
+            if (frame == 0)
+            {
+                shader.groupHidden.resize(getQuadGroupCount(shader), 0);
+                shader.groupDrawOrder.reserve(benchmarkRaisedGroups);
+            }
+            else if (frame % settings.groupChangeFrames == 0)
+            {
+                changeQuadGroups(shader, groupRandom);
+            }
+        }
+
+        endMainThreadProfileScope();
+
+        std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+
+        recordBeginProfileScope("renderFrame");
+
+        recordCall(startRenderTimer, &sample);
+
+        path.renderFrame();
+
+        recordCall(storeRenderTime, &sample);
+
+        recordEndProfileScope();
+
+        std::chrono::steady_clock::time_point presentStart = std::chrono::steady_clock::now();
+
+        recordBeginProfileScope("present");
+
+        recordPresent();
+
+        recordEndProfileScope();
+
+        recordCall(storeUploadStats, &sample);
+
+        recordEndProfilerFrame();
+
+        submitRenderCommands();
+
+        std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+
+        sample.frameMs = millisecondsBetween(frameStart, frameEnd);
+        sample.buildMs = millisecondsBetween(buildStart, renderStart);
+        sample.presentMs = millisecondsBetween(presentStart, frameEnd);
+
+        if (frame >= settings.warmupFrames)
+        {
+            measuredFrames++;
+        }
+
+        if (checkAllocations == true)
+        {
+            endAllocationCheck(path.name, frame);
+        }
+    }
+
+    stopRenderThread();
+
+    samples.resize(measuredFrames);
+
+    result.gpuBufferBytes = getGpuBufferArenaBytes();
+
+    // Hidden groups and the draw order outlive the scene, and the next run
+    // shouldn't inherit them.
+    if (benchmarkSceneShader != NULL)
+    {
+        benchmarkSceneShader->groupHidden.clear();
+
+        setQuadGroupDrawOrder(*benchmarkSceneShader, std::vector<int>());
+    }
+
+    path.shutdown();
+
+    setCamera(startCamera);
+
+    benchmarkScene = NULL;
+    benchmarkSceneShader = NULL;
+
+    if (profilerEnabled == true)
+    {
+        getProfileStats(result.scopes);
+    }
+
+    std::vector<double> frameMs, buildMs, drawMs, presentMs;
+
+    double totalUploadBytes = 0.0;
+    double totalSkippedBytes = 0.0;
+    double totalUploadMs = 0.0;
+
+    uint64_t totalFenceWaits = 0;
+
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        frameMs.push_back(samples[i].frameMs);
+        buildMs.push_back(samples[i].buildMs);
+
+        // Draw is everything the path submits other than the buffer upload.
+        drawMs.push_back(std::max(0.0, samples[i].renderMs - samples[i].uploadMs));
+        presentMs.push_back(samples[i].presentMs);
+
+        totalUploadBytes += samples[i].uploadBytes;
+        totalSkippedBytes += samples[i].skippedBytes;
+        totalUploadMs += samples[i].uploadMs;
+        totalFenceWaits += samples[i].fenceWaits;
+    }
+
+    result.pathName = path.name;
+    result.quadCount = quadCount;
+    result.frames = samples.size();
+    result.frameMs = summarize(frameMs);
+    result.buildMs = summarize(buildMs);
+    result.drawMs = summarize(drawMs);
+    result.presentMs = summarize(presentMs);
+    result.uploadBytesPerFrame = samples.empty() ? 0.0 : totalUploadBytes / samples.size();
+    result.skippedBytesPerFrame = samples.empty() ? 0.0 : totalSkippedBytes / samples.size();
+    result.uploadMsPerFrame = samples.empty() ? 0.0 : totalUploadMs / samples.size();
+    result.uploadBytesPerSecond = totalUploadMs > 0.0 ? totalUploadBytes / (totalUploadMs / 1000.0) : 0.0;
+    result.uploadFenceWaits = totalFenceWaits;
+    result.peakMemoryBytes = getPeakMemoryBytes();
+
+    return true;
+}
+
+static std::string jsonString(const char* text)
+{
+    std::string escaped = "\"";
+
+    for (const char* c = text; c != NULL && *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            escaped += '\\';
+        }
+
+        escaped += *c;
+    }
+
+    return escaped + "\"";
+}
+
+static void writeSummary(std::ostream& out, const char* name, const TimingSummary& summary)
+{
+    out << "      " << jsonString(name) << ": { "
+        << "\"mean\": " << summary.mean << ", "
+        << "\"min\": " << summary.min << ", "
+        << "\"p50\": " << summary.p50 << ", "
+        << "\"p90\": " << summary.p90 << ", "
+        << "\"p99\": " << summary.p99 << ", "
+        << "\"max\": " << summary.max << " }";
+}
+
+static void writeJson(std::ostream& out, const BenchmarkSettings& settings, const std::vector<BenchmarkResult>& results)
+{
+    out << "{" << std::endl;
+    out << "  \"renderer\": " << jsonString((const char*)glGetString(GL_RENDERER)) << "," << std::endl;
+    out << "  \"gl_version\": " << jsonString((const char*)glGetString(GL_VERSION)) << "," << std::endl;
+    out << "  \"upload_mode\": " << jsonString(uploadModeName(uploadMode)) << "," << std::endl;
+    out << "  \"instanced\": " << (instancedQuads ? "true" : "false") << "," << std::endl;
+    out << "  \"retained\": " << (retainedQuads ? "true" : "false") << "," << std::endl;
+    out << "  \"grouped_draws\": " << (groupedDraws ? "true" : "false") << "," << std::endl;
+    out << "  \"viewport_culling\": " << (viewportCulling ? "true" : "false") << "," << std::endl;
+    out << "  \"upload_hash\": " << (skipUnchangedUploads ? "true" : "false") << "," << std::endl;
+    out << "  \"vertex_format\": " << jsonString(vertexFormatName(vertexFormat)) << "," << std::endl;
+    out << "  \"threads\": " << getJobThreadCount() << "," << std::endl;
+    out << "  \"render_thread\": " << (renderThreadEnabled ? "true" : "false") << "," << std::endl;
+    out << "  \"transform_kernel\": " << jsonString(transformKernelName(activeTransformKernel())) << "," << std::endl;
+    out << "  \"headless\": " << (headless ? "true" : "false") << "," << std::endl;
+    out << "  \"screen\": [" << screenWidth << ", " << screenHeight << "]," << std::endl;
+    out << "  \"seed\": " << settings.seed << "," << std::endl;
+    out << "  \"warmup_frames\": " << settings.warmupFrames << "," << std::endl;
+    out << "  \"group_size\": " << settings.groupSize << "," << std::endl;
+    out << "  \"scale\": [" << settings.minScale << ", " << settings.maxScale << "]," << std::endl;
+    out << "  \"max_rotation\": " << settings.maxRotation << "," << std::endl;
+    out << "  \"world_scale\": " << settings.worldScale << "," << std::endl;
+    out << "  \"pan_pixels\": " << settings.panPixels << "," << std::endl;
+    out << "  \"mutate_percent\": " << settings.mutatePercent << "," << std::endl;
+    out << "  \"group_change_frames\": " << settings.groupChangeFrames << "," << std::endl;
+    out << "  \"results\": [" << std::endl;
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& result = results[i];
+
+        out << "    {" << std::endl;
+        out << "      \"path\": " << jsonString(result.pathName.c_str()) << "," << std::endl;
+        out << "      \"quads\": " << result.quadCount << "," << std::endl;
+        out << "      \"frames\": " << result.frames << "," << std::endl;
+        writeSummary(out, "frame_ms", result.frameMs);
+        out << "," << std::endl;
+        writeSummary(out, "build_ms", result.buildMs);
+        out << "," << std::endl;
+        writeSummary(out, "draw_ms", result.drawMs);
+        out << "," << std::endl;
+        writeSummary(out, "present_ms", result.presentMs);
+        out << "," << std::endl;
+        out << "      \"upload_bytes_per_frame\": " << (uint64_t)result.uploadBytesPerFrame << "," << std::endl;
+        out << "      \"upload_skipped_bytes_per_frame\": " << (uint64_t)result.skippedBytesPerFrame << "," << std::endl;
+        out << "      \"upload_ms_per_frame\": " << result.uploadMsPerFrame << "," << std::endl;
+        out << "      \"upload_bytes_per_second\": " << (uint64_t)result.uploadBytesPerSecond << "," << std::endl;
+        out << "      \"upload_fence_waits\": " << result.uploadFenceWaits << "," << std::endl;
+        out << "      \"peak_memory_bytes\": " << result.peakMemoryBytes << "," << std::endl;
+        out << "      \"gpu_buffer_bytes\": " << result.gpuBufferBytes << "," << std::endl;
+        out << "      \"visible_quads\": " << result.visibleQuads << "," << std::endl;
+        out << "      \"culled_quads\": " << result.culledQuads << (result.scopes.empty() ? "" : ",") << std::endl;
+
+        if (result.scopes.empty() == false)
+        {
+            out << "      \"scopes\": [" << std::endl;
+
+            for (size_t s = 0; s < result.scopes.size(); s++)
+            {
+                const ProfileStats& scope = result.scopes[s];
+
+                out << "        { \"name\": " << jsonString(scope.name.c_str())
+                    << ", \"depth\": " << scope.depth
+                    << ", \"calls_per_frame\": " << scope.callsPerFrame
+                    << ", \"cpu_ms\": { \"mean\": " << scope.cpuMean << ", \"p50\": " << scope.cpuP50 << ", \"p95\": " << scope.cpuP95 << ", \"p99\": " << scope.cpuP99 << " }"
+                    << ", \"gpu_ms\": { \"mean\": " << scope.gpuMean << ", \"p50\": " << scope.gpuP50 << ", \"p95\": " << scope.gpuP95 << ", \"p99\": " << scope.gpuP99 << " } }"
+                    << (s + 1 < result.scopes.size() ? "," : "") << std::endl;
+            }
+
+            out << "      ]" << std::endl;
+        }
+        out << "    }" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+}
+
+bool runBenchmark(RenderPath** paths, int pathCount, const BenchmarkSettings& settings)
+{
+    std::vector<BenchmarkResult> results;
+
+    bool ok = true;
+    bool quit = false;
+
+    // Packed vertices would clamp quads at the edge of a world wider than shorts reach.
+    float worldReach = 0.5f * std::max(screenWidth, screenHeight) * settings.worldScale;
+
+    if (vertexFormat == VERTEX_FORMAT_PACKED && worldReach > packedVertexLimit)
+    {
+        std::cerr << "--world " << settings.worldScale << " reaches " << worldReach << " world units, past the " << packedVertexLimit << " of packed vertices, so compact vertices are used" << std::endl;
+
+        vertexFormat = VERTEX_FORMAT_COMPACT;
+    }
+
+    // Smallest scenes first, so the peak memory column grows with the quad count.
+    for (size_t c = 0; c < settings.quadCounts.size() && quit == false; c++)
+    {
+        for (int p = 0; p < pathCount && quit == false; p++)
+        {
+            BenchmarkResult result;
+
+            std::cerr << "Benchmarking " << paths[p]->name << " with " << settings.quadCounts[c] << " quads" << std::endl;
+
+            if (benchmarkPath(*paths[p], settings.quadCounts[c], settings, result, quit) == false)
+            {
+                ok = false;
+
+                continue;
+            }
+
+            results.push_back(result);
+        }
+    }
+
+    if (settings.jsonFilename.empty() == true)
+    {
+        writeJson(std::cout, settings, results);
+    }
+    else
+    {
+        std::ofstream file(settings.jsonFilename.c_str());
+
+        if (file.is_open() == false)
+        {
+            std::cout << "Failed to open benchmark output " << settings.jsonFilename << std::endl;
+
+            return false;
+        }
+
+        writeJson(file, settings, results);
+    }
+
+    return ok;
+}
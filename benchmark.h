@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "render_path.h"
+#include "testbed.h"
+
+struct BenchmarkSettings
+{
+    bool                enabled;
+    std::vector<int>    quadCounts;
+    uint32_t            seed;
+    int                 warmupFrames;
+    int                 frames;
+
+    // Average number of quads sharing a group color. 1 starts a new group on every quad.
+    int                 groupSize;
+
+    float               minScale;
+    float               maxScale;
+
+    // Rotations are drawn from [-maxRotation, maxRotation] degrees. Zero keeps quads axis aligned.
+    float               maxRotation;
+
+    // The scene spans this many screens each way, centered on the screen. Above
+    // 1 most quads are offscreen, for the viewport culling.
+    float               worldScale;
+
+    // Screen pixels the camera pans right every frame, to measure a moving view.
+    float               panPixels;
+
+    // With --retained, the percent of the scene's quads changed every frame
+    // after the first, through a QuadStore: half moved, half destroyed and
+    // created again.
+    float               mutatePercent;
+
+    // Every this many frames, hide or show one group and raise another, so
+    // group draws rebuild their commands. 0 leaves every group as built.
+    int                 groupChangeFrames;
+
+    // Empty writes the JSON results to stdout.
+    std::string         jsonFilename;
+};
+
+// Reads --benchmark, --quads <n,n,...>, --seed <n>, --warmup <n>, --group-size <n>,
+// --scale <min,max>, --rotation <degrees>, --world <n>, --pan <pixels>,
+// --mutate <percent>, --group-changes <frames> and --json <file>. --frames sets the measured frames.
+void parseBenchmarkArgs(int argc, char* argv[], BenchmarkSettings& settings);
+
+// Fill quads with a reproducible scene: the same settings and count always give the same quads.
+void generateScene(std::vector<QuadParams>& quads, int quadCount, const BenchmarkSettings& settings);
+
+bool runBenchmark(RenderPath** paths, int pathCount, const BenchmarkSettings& settings);
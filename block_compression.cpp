@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <GL/glew.h>
+
+#include "block_compression.h"
+#include "job_system.h"
+
+// Block rows a job encodes at least.
+static const int compressionRowGrain = 4;
+
+const char* textureCompressionName(TextureCompression compression)
+{
+    switch (compression)
+    {
+    case TEXTURE_COMPRESSION_BC1:
+        return "bc1";
+
+    case TEXTURE_COMPRESSION_BC3:
+        return "bc3";
+
+    default:
+        return "none";
+    }
+}
+
+GLenum getCompressedInternalFormat(TextureCompression compression)
+{
+    switch (compression)
+    {
+    case TEXTURE_COMPRESSION_BC1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+    case TEXTURE_COMPRESSION_BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+    default:
+        return GL_RGBA8;
+    }
+}
+
+TextureCompression getTextureCompression(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        return TEXTURE_COMPRESSION_BC1;
+
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return TEXTURE_COMPRESSION_BC3;
+
+    default:
+        return TEXTURE_COMPRESSION_NONE;
+    }
+}
+
+size_t getCompressedLevelBytes(TextureCompression compression, int width, int height)
+{
+    size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+
+    switch (compression)
+    {
+    case TEXTURE_COMPRESSION_BC1:
+        return blocks * 8;
+
+    case TEXTURE_COMPRESSION_BC3:
+        return blocks * 16;
+
+    default:
+        return (size_t)width * height * 4;
+    }
+}
+
+static uint16_t packRgb565(const int color[3])
+{
+    return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void unpackRgb565(uint16_t packed, int color[3])
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// The two 565 endpoints and the 2 bit palette index of each pixel, always in
+// the four color mode, which BC3 requires and opaque BC1 wants.
+static void encodeColorBlock(const unsigned char block[64], unsigned char* out)
+{
+    int low[3] = { 255, 255, 255 };
+    int high[3] = { 0, 0, 0 };
+
+    int mean[3] = { 0, 0, 0 };
+
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            low[c] = std::min(low[c], (int)block[i * 4 + c]);
+            high[c] = std::max(high[c], (int)block[i * 4 + c]);
+
+            mean[c] += block[i * 4 + c];
+        }
+    }
+
+    // The box's main diagonal runs low to high in every channel. Red or blue
+    // falling as green rises means the colors lie along another one.
+    int covarianceRed = 0;
+    int covarianceBlue = 0;
+
+    for (int i = 0; i < 16; i++)
+    {
+        int green = block[i * 4 + 1] * 16 - mean[1];
+
+        covarianceRed += (block[i * 4 + 0] * 16 - mean[0]) * green;
+        covarianceBlue += (block[i * 4 + 2] * 16 - mean[2]) * green;
+    }
+
+    if (covarianceRed < 0)
+    {
+        std::swap(low[0], high[0]);
+    }
+
+    if (covarianceBlue < 0)
+    {
+        std::swap(low[2], high[2]);
+    }
+
+    // Pull the ends in by a sixteenth, so outliers don't stretch the palette past the rest.
+    for (int c = 0; c < 3; c++)
+    {
+        int inset = (high[c] - low[c]) / 16;
+
+        high[c] -= inset;
+        low[c] += inset;
+    }
+
+    uint16_t color0 = packRgb565(high);
+    uint16_t color1 = packRgb565(low);
+
+    // The four color mode is the one with color0 above color1.
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+
+    if (color0 != color1)
+    {
+        int palette[4][3];
+
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0;
+            int bestDistance = 0x7FFFFFFF;
+
+            for (int p = 0; p < 4; p++)
+            {
+                int distance = 0;
+
+                for (int c = 0; c < 3; c++)
+                {
+                    int d = block[i * 4 + c] - palette[p][c];
+
+                    distance += d * d;
+                }
+
+                if (distance < bestDistance)
+                {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+
+            indices |= (uint32_t)best << (i * 2);
+        }
+    }
+
+    out[0] = color0 & 0xFF;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF;
+    out[3] = color1 >> 8;
+    out[4] = indices & 0xFF;
+    out[5] = (indices >> 8) & 0xFF;
+    out[6] = (indices >> 16) & 0xFF;
+    out[7] = indices >> 24;
+}
+
+// The block's highest and lowest alpha and a 3 bit index of each pixel into
+// the eight values from one to the other.
+static void encodeAlphaBlock(const unsigned char block[64], unsigned char* out)
+{
+    int alpha0 = 0;
+    int alpha1 = 255;
+
+    for (int i = 0; i < 16; i++)
+    {
+        alpha0 = std::max(alpha0, (int)block[i * 4 + 3]);
+        alpha1 = std::min(alpha1, (int)block[i * 4 + 3]);
+    }
+
+    uint64_t indices = 0;
+
+    if (alpha0 != alpha1)
+    {
+        int palette[8];
+
+        palette[0] = alpha0;
+        palette[1] = alpha1;
+
+        for (int p = 1; p < 7; p++)
+        {
+            palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0;
+            int bestDistance = 256;
+
+            for (int p = 0; p < 8; p++)
+            {
+                int distance = abs(block[i * 4 + 3] - palette[p]);
+
+                if (distance < bestDistance)
+                {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+
+            indices |= (uint64_t)best << (i * 3);
+        }
+    }
+
+    out[0] = (unsigned char)alpha0;
+    out[1] = (unsigned char)alpha1;
+
+    for (int i = 0; i < 6; i++)
+    {
+        out[2 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+}
+
+static void compressBlockRows(TextureCompression compression, const unsigned char* pixels, int width, int height, unsigned char* blocks, int begin, int end)
+{
+    int blockColumns = (width + 3) / 4;
+
+    int blockBytes = (compression == TEXTURE_COMPRESSION_BC1) ? 8 : 16;
+
+    unsigned char block[64];
+
+    for (int blockY = begin; blockY < end; blockY++)
+    {
+        for (int blockX = 0; blockX < blockColumns; blockX++)
+        {
+            for (int y = 0; y < 4; y++)
+            {
+                int sourceY = std::min(blockY * 4 + y, height - 1);
+
+                for (int x = 0; x < 4; x++)
+                {
+                    int sourceX = std::min(blockX * 4 + x, width - 1);
+
+                    memcpy(block + (y * 4 + x) * 4, pixels + ((size_t)sourceY * width + sourceX) * 4, 4);
+                }
+            }
+
+            unsigned char* out = blocks + ((size_t)blockY * blockColumns + blockX) * blockBytes;
+
+            if (compression == TEXTURE_COMPRESSION_BC3)
+            {
+                encodeAlphaBlock(block, out);
+
+                out += 8;
+            }
+
+            encodeColorBlock(block, out);
+        }
+    }
+}
+
+void compressTextureLevel(TextureCompression compression, const unsigned char* pixels, int width, int height, unsigned char* blocks, bool parallel)
+{
+    if (compression == TEXTURE_COMPRESSION_NONE)
+    {
+        memcpy(blocks, pixels, (size_t)width * height * 4);
+
+        return;
+    }
+
+    auto body = [=](int begin, int end)
+    {
+        compressBlockRows(compression, pixels, width, height, blocks, begin, end);
+    };
+
+    int blockRows = (height + 3) / 4;
+
+    if (parallel == true)
+    {
+        parallelFor(blockRows, compressionRowGrain, body);
+    }
+    else
+    {
+        body(0, blockRows);
+    }
+}
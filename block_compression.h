@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+#include <GL/glew.h>
+
+// Block compressed formats textures can be baked in. Each 4x4 block of
+// pixels becomes 8 bytes (BC1, opaque) or 16 (BC3, with alpha), an eighth or
+// a quarter of RGBA8.
+enum TextureCompression
+{
+    TEXTURE_COMPRESSION_NONE,
+    TEXTURE_COMPRESSION_BC1,
+    TEXTURE_COMPRESSION_BC3
+};
+
+const char* textureCompressionName(TextureCompression compression);
+
+// The GL internal format, GL_RGBA8 for none.
+GLenum getCompressedInternalFormat(TextureCompression compression);
+
+// The compression of a GL internal format, TEXTURE_COMPRESSION_NONE for any other.
+TextureCompression getTextureCompression(GLenum internalFormat);
+
+// Bytes of a width x height level, partial blocks at the edges included.
+size_t getCompressedLevelBytes(TextureCompression compression, int width, int height);
+
+// Encode a width x height RGBA8 level into getCompressedLevelBytes() of
+// blocks, row of blocks after row. Endpoints are the block's bounding box,
+// turned along the diagonal its colors lie on and inset a little, and each
+// pixel takes the nearest of the palette between them. Pixels past an edge
+// repeat it. With parallel set, block rows are split over the job threads.
+void compressTextureLevel(TextureCompression compression, const unsigned char* pixels, int width, int height, unsigned char* blocks, bool parallel);
@@ -0,0 +1,100 @@
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "camera.h"
+#include "screen.h"
+#include "testbed.h"
+
+static const float degreesToRadians = 3.14159265358979f / 180.0f;
+
+static Camera2D camera = { 0.0f, 0.0f, 1.0f, 0.0f };
+
+static uint32_t cameraVersion = 1;
+
+// Keep modelViewMatrix in step with the camera.
+static void cameraChanged()
+{
+    cameraVersion++;
+
+    modelViewMatrix = getCameraViewMatrix();
+}
+
+void resetCamera()
+{
+    setCamera(Camera2D{ 0.0f, 0.0f, 1.0f, 0.0f });
+}
+
+void setCamera(const Camera2D& newCamera)
+{
+    camera = newCamera;
+
+    cameraChanged();
+}
+
+const Camera2D& getCamera()
+{
+    return camera;
+}
+
+void panCamera(float dx, float dy)
+{
+    // Screen pixels back into world units: unrotate, then unzoom.
+    float sinTheta = sinf(camera.rotationDegrees * degreesToRadians);
+    float cosTheta = cosf(camera.rotationDegrees * degreesToRadians);
+
+    camera.x += (dx * cosTheta - dy * sinTheta) / camera.zoom;
+    camera.y += (dx * sinTheta + dy * cosTheta) / camera.zoom;
+
+    cameraChanged();
+}
+
+void zoomCamera(float factor)
+{
+    camera.zoom *= factor;
+
+    cameraChanged();
+}
+
+void rotateCamera(float degrees)
+{
+    camera.rotationDegrees += degrees;
+
+    cameraChanged();
+}
+
+uint32_t getCameraVersion()
+{
+    return cameraVersion;
+}
+
+glm::mat4 getCameraViewMatrix()
+{
+    // Read right to left: the camera point to the origin, zoom, turn the world
+    // the other way from the view, then the origin to the screen center.
+    glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(screenWidth / 2, screenHeight / 2, 0.0f));
+
+    view = glm::rotate(view, -camera.rotationDegrees * degreesToRadians, glm::vec3(0.0f, 0.0f, 1.0f));
+    view = glm::scale(view, glm::vec3(camera.zoom, camera.zoom, 1.0f));
+    view = glm::translate(view, glm::vec3(-camera.x, -camera.y, 0.0f));
+
+    return view;
+}
+
+CullRect getCameraCullRect()
+{
+    // The screen's half size in world units, turned with the view: its
+    // bounding box reaches |w cos| + |h sin| across and |w sin| + |h cos| down.
+    float halfWidth = screenWidth / 2 / camera.zoom;
+    float halfHeight = screenHeight / 2 / camera.zoom;
+
+    float sinTheta = fabsf(sinf(camera.rotationDegrees * degreesToRadians));
+    float cosTheta = fabsf(cosf(camera.rotationDegrees * degreesToRadians));
+
+    float extentX = halfWidth * cosTheta + halfHeight * sinTheta;
+    float extentY = halfWidth * sinTheta + halfHeight * cosTheta;
+
+    return CullRect{ camera.x - extentX, camera.y - extentY, camera.x + extentX, camera.y + extentY };
+}
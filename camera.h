@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "quad_transform.h"
+
+// The 2D view of the world the quads are stored in. The world point (x, y) is
+// at the screen center, a world unit spans zoom pixels, and the view is turned
+// rotationDegrees clockwise. The default camera shows world (0, 0) at the
+// screen center, one pixel per unit, where addQuad() used to place quads.
+struct Camera2D
+{
+    float   x;
+    float   y;
+    float   zoom;
+    float   rotationDegrees;
+};
+
+// Back to the default camera.
+void resetCamera();
+
+void setCamera(const Camera2D& camera);
+
+const Camera2D& getCamera();
+
+// Move the view dx, dy screen pixels, whatever the zoom and rotation.
+void panCamera(float dx, float dy);
+
+// Multiply the zoom by factor, about the screen center.
+void zoomCamera(float factor);
+
+void rotateCamera(float degrees);
+
+// Changes with every camera change, so shaders can tell when the view matrix
+// they were last given is stale.
+uint32_t getCameraVersion();
+
+// World to screen pixels, for the projection to take to clip space. Also
+// kept in modelViewMatrix.
+glm::mat4 getCameraViewMatrix();
+
+// The world rectangle around what the screen shows, for culling.
+CullRect getCameraCullRect();
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// XXH64 of bytes bytes at data. Fast enough to hash a frame's vertices to
+// find the parts that didn't change, not meant to resist deliberate collisions.
+uint64_t hashBytes(const void* data, size_t bytes, uint64_t seed = 0);
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "frame_arena.h"
+
+// One block of arena memory. The bytes follow the header.
+struct ArenaBlock
+{
+    ArenaBlock*     previous;
+    size_t          capacity;
+    size_t          used;
+};
+
+// The block being allocated from. Earlier blocks of the same frame hang off it.
+static ArenaBlock*  currentBlock = NULL;
+
+// Bytes handed out this frame, over all blocks, and the most in any frame.
+static size_t       frameUsedBytes = 0;
+static size_t       framePeakBytes = 0;
+
+static std::atomic<uint64_t>    heapAllocationCount(0);
+
+static uint64_t                 allocationsAtFrameStart = 0;
+
+// The arena takes its blocks straight from malloc so they don't count as heap allocations.
+static ArenaBlock* createBlock(size_t capacity, ArenaBlock* previous)
+{
+    ArenaBlock* block = static_cast<ArenaBlock*>(malloc(sizeof(ArenaBlock) + capacity));
+
+    if (block == NULL)
+    {
+        std::cout << "Frame arena failed to allocate " << capacity << " bytes" << std::endl;
+
+        abort();
+    }
+
+    block->previous = previous;
+    block->capacity = capacity;
+    block->used = 0;
+
+    return block;
+}
+
+static void freeBlocks()
+{
+    while (currentBlock != NULL)
+    {
+        ArenaBlock* previous = currentBlock->previous;
+
+        free(currentBlock);
+
+        currentBlock = previous;
+    }
+}
+
+static char* blockMemory(ArenaBlock* block)
+{
+    return reinterpret_cast<char*>(block + 1);
+}
+
+// Offset in the block of the next allocation aligned to alignment, a power of two.
+static size_t alignedOffset(ArenaBlock* block, size_t alignment)
+{
+    uintptr_t address = reinterpret_cast<uintptr_t>(blockMemory(block)) + block->used;
+
+    return ((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - reinterpret_cast<uintptr_t>(blockMemory(block));
+}
+
+void* frameArenaAllocate(size_t bytes, size_t alignment)
+{
+    if (currentBlock == NULL)
+    {
+        currentBlock = createBlock(std::max(frameArenaInitialBytes, bytes + alignment), NULL);
+    }
+
+    size_t offset = alignedOffset(currentBlock, alignment);
+
+    if (offset + bytes > currentBlock->capacity)
+    {
+        // Spill into a new block for the rest of the frame, at least twice the last one.
+        currentBlock = createBlock(std::max(currentBlock->capacity * 2, bytes + alignment), currentBlock);
+
+        offset = alignedOffset(currentBlock, alignment);
+    }
+
+    currentBlock->used = offset + bytes;
+
+    frameUsedBytes += bytes;
+
+    return blockMemory(currentBlock) + offset;
+}
+
+void resetFrameArena()
+{
+    framePeakBytes = std::max(framePeakBytes, frameUsedBytes);
+
+    frameUsedBytes = 0;
+
+    if (currentBlock == NULL)
+    {
+        return;
+    }
+
+    if (currentBlock->previous != NULL)
+    {
+        // Replace the chain with one block that fits the whole frame, padding included.
+        size_t capacity = 0;
+
+        for (ArenaBlock* block = currentBlock; block != NULL; block = block->previous)
+        {
+            capacity += block->capacity;
+        }
+
+        freeBlocks();
+
+        currentBlock = createBlock(capacity, NULL);
+    }
+
+    currentBlock->used = 0;
+}
+
+void freeFrameArena()
+{
+    freeBlocks();
+
+    frameUsedBytes = 0;
+}
+
+size_t getFrameArenaUsedBytes()
+{
+    return frameUsedBytes;
+}
+
+size_t getFrameArenaPeakBytes()
+{
+    return std::max(framePeakBytes, frameUsedBytes);
+}
+
+uint64_t getHeapAllocationCount()
+{
+    return heapAllocationCount.load(std::memory_order_relaxed);
+}
+
+void beginAllocationCheck()
+{
+    allocationsAtFrameStart = getHeapAllocationCount();
+}
+
+void endAllocationCheck(const char* where, int frame)
+{
+#ifdef TESTBED_COUNT_ALLOCATIONS
+    uint64_t allocations = getHeapAllocationCount() - allocationsAtFrameStart;
+
+    if (allocations > 0)
+    {
+        std::cout << where << ": frame " << frame << " made " << allocations << " heap allocations" << std::endl;
+
+        abort();
+    }
+#else
+    (void)where;
+    (void)frame;
+#endif
+}
+
+#ifdef TESTBED_COUNT_ALLOCATIONS
+
+// Replacing the plain forms is enough: the array and nothrow forms call them.
+void* operator new(size_t size)
+{
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    void* memory = malloc(size == 0 ? 1 : size);
+
+    if (memory == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+#endif
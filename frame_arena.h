@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Size of the arena's first block. It grows to fit the largest frame seen.
+const size_t frameArenaInitialBytes = 1 << 20;
+
+// Frames after a path starts, or after the benchmark's warmup, that may still
+// allocate while buffers, the arena and the profiler history grow to size.
+const int allocationCheckWarmupFrames = 10;
+
+// Scratch memory valid until the next resetFrameArena(). Never freed one by one.
+void* frameArenaAllocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+// Uninitialized storage for count objects. Only for types that need no construction.
+template<typename T>
+T* frameArenaAllocateArray(size_t count)
+{
+    return static_cast<T*>(frameArenaAllocate(count * sizeof(T), alignof(T)));
+}
+
+// Release everything allocated since the last reset. Called at the top of every
+// frame. A frame that outgrew the arena spilled into extra blocks; they are
+// merged here into one block big enough for it, so the next frame fits.
+void resetFrameArena();
+
+void freeFrameArena();
+
+// Bytes handed out since the last reset, and the most handed out in one frame.
+size_t getFrameArenaUsedBytes();
+
+size_t getFrameArenaPeakBytes();
+
+// Global operator new calls so far. Only counted when built with
+// TESTBED_COUNT_ALLOCATIONS, always 0 otherwise.
+uint64_t getHeapAllocationCount();
+
+// Call at the start and end of a frame. With TESTBED_COUNT_ALLOCATIONS, a frame
+// that allocated from the heap reports where and aborts. Does nothing otherwise.
+void beginAllocationCheck();
+
+void endAllocationCheck(const char* where, int frame);
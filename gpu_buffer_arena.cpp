@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gpu_buffer_arena.h"
+#include "testbed.h"
+
+struct FreeRange
+{
+    GLintptr    offset;
+    GLsizeiptr  bytes;
+};
+
+// One backing buffer and its free ranges, sorted by offset and never adjacent.
+struct GpuBufferBlock
+{
+    GLuint                  bufferId;
+    GLsizeiptr              bytes;
+    void*                   mapping;
+    UploadMode              mode;
+
+    // Holds a single range and is deleted with it.
+    bool                    dedicated;
+
+    std::vector<FreeRange>  freeRanges;
+};
+
+// A freed range waiting for the GPU to pass fence.
+struct RetiredRange
+{
+    int         block;
+    FreeRange   range;
+    GLsync      fence;
+};
+
+static std::vector<GpuBufferBlock>  blocks;
+static std::vector<RetiredRange>    retiredRanges;
+
+static GLsizeiptr                   usedBytes = 0;
+
+static void addFreeRange(GpuBufferBlock& block, FreeRange range)
+{
+    std::vector<FreeRange>& ranges = block.freeRanges;
+
+    std::vector<FreeRange>::iterator next = std::lower_bound(ranges.begin(), ranges.end(), range, [](const FreeRange& a, const FreeRange& b) { return a.offset < b.offset; });
+
+    // Merge with the free neighbors, so fragmentation doesn't outlive the ranges causing it.
+    if (next != ranges.end() && range.offset + range.bytes == next->offset)
+    {
+        range.bytes += next->bytes;
+
+        next = ranges.erase(next);
+    }
+
+    if (next != ranges.begin() && (next - 1)->offset + (next - 1)->bytes == range.offset)
+    {
+        (next - 1)->bytes += range.bytes;
+
+        return;
+    }
+
+    ranges.insert(next, range);
+}
+
+// Make the ranges the GPU is done with available again.
+static void reclaimRetiredRanges()
+{
+    size_t kept = 0;
+
+    for (size_t i = 0; i < retiredRanges.size(); i++)
+    {
+        RetiredRange& retired = retiredRanges[i];
+
+        if (glClientWaitSync(retired.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            retiredRanges[kept++] = retired;
+
+            continue;
+        }
+
+        glDeleteSync(retired.fence);
+
+        addFreeRange(blocks[retired.block], retired.range);
+    }
+
+    retiredRanges.resize(kept);
+}
+
+static bool createBlock(GpuBufferBlock& block, GLsizeiptr bytes, bool dedicated)
+{
+    block.bytes = bytes;
+    block.mapping = NULL;
+    block.mode = uploadMode;
+    block.dedicated = dedicated;
+    block.freeRanges.clear();
+
+    glGenBuffers(1, &block.bufferId);
+
+    // Not through GL_ARRAY_BUFFER, whose binding the VAO setup relies on.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, block.bufferId);
+
+    if (uploadMode == UPLOAD_PERSISTENT_RING)
+    {
+        // Mapped once for the lifetime of the buffer. Coherent, so writes need no explicit flush.
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage(GL_COPY_WRITE_BUFFER, bytes, NULL, flags);
+        block.mapping = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bytes, flags);
+
+        if (block.mapping == NULL)
+        {
+            std::cout << "Error mapping persistent vertex buffer" << std::endl;
+        }
+    }
+    else
+    {
+        GLenum usage = (uploadMode == UPLOAD_SUB_DATA) ? GL_DYNAMIC_DRAW : GL_STREAM_DRAW;
+
+        glBufferData(GL_COPY_WRITE_BUFFER, bytes, NULL, usage);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    GLenum error = glGetError();
+
+    if (error != GL_NO_ERROR || (uploadMode == UPLOAD_PERSISTENT_RING && block.mapping == NULL))
+    {
+        std::cout << "Error creating vertex buffer: " << gluErrorString(error) << std::endl;
+
+        glDeleteBuffers(1, &block.bufferId);
+
+        block.bufferId = 0;
+
+        return false;
+    }
+
+    block.freeRanges.push_back(FreeRange{ 0, bytes });
+
+    return true;
+}
+
+// Carve bytes at an aligned offset out of the block's first free range that fits.
+static bool allocateFromBlock(GpuBufferBlock& block, GLsizeiptr bytes, GLsizeiptr alignment, GLintptr& offset)
+{
+    for (size_t i = 0; i < block.freeRanges.size(); i++)
+    {
+        FreeRange range = block.freeRanges[i];
+
+        GLintptr aligned = (range.offset + alignment - 1) / alignment * alignment;
+
+        if (aligned + bytes > range.offset + range.bytes)
+        {
+            continue;
+        }
+
+        block.freeRanges.erase(block.freeRanges.begin() + i);
+
+        if (aligned > range.offset)
+        {
+            addFreeRange(block, FreeRange{ range.offset, aligned - range.offset });
+        }
+
+        if (aligned + bytes < range.offset + range.bytes)
+        {
+            addFreeRange(block, FreeRange{ aligned + bytes, range.offset + range.bytes - aligned - bytes });
+        }
+
+        offset = aligned;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool allocateGpuBufferRange(GpuBufferRange& range, GLsizeiptr bytes, GLsizeiptr alignment)
+{
+    range.bufferId = 0;
+    range.offset = 0;
+    range.bytes = 0;
+    range.mapping = NULL;
+    range.block = 0;
+
+    reclaimRetiredRanges();
+
+    bool dedicated = (uploadMode == UPLOAD_MAP_UNSYNCHRONIZED);
+
+    int blockIndex = -1;
+
+    GLintptr offset = 0;
+
+    for (size_t i = 0; i < blocks.size() && blockIndex < 0 && dedicated == false; i++)
+    {
+        if (blocks[i].bufferId != 0 && blocks[i].dedicated == false && blocks[i].mode == uploadMode && allocateFromBlock(blocks[i], bytes, alignment, offset))
+        {
+            blockIndex = i;
+        }
+    }
+
+    if (blockIndex < 0)
+    {
+        // Reuse the slot of a deleted block, so indices held by ranges stay put.
+        for (size_t i = 0; i < blocks.size() && blockIndex < 0; i++)
+        {
+            if (blocks[i].bufferId == 0)
+            {
+                blockIndex = i;
+            }
+        }
+
+        if (blockIndex < 0)
+        {
+            blockIndex = blocks.size();
+
+            blocks.push_back(GpuBufferBlock());
+        }
+
+        GpuBufferBlock& block = blocks[blockIndex];
+
+        if (createBlock(block, dedicated ? bytes : std::max(bytes, gpuBufferBlockBytes), dedicated) == false)
+        {
+            return false;
+        }
+
+        allocateFromBlock(block, bytes, alignment, offset);
+    }
+
+    GpuBufferBlock& block = blocks[blockIndex];
+
+    range.bufferId = block.bufferId;
+    range.offset = offset;
+    range.bytes = bytes;
+    range.mapping = (block.mapping != NULL) ? (char*)block.mapping + offset : NULL;
+    range.block = blockIndex;
+
+    usedBytes += bytes;
+
+    return true;
+}
+
+static void deleteBlock(GpuBufferBlock& block)
+{
+    if (block.bufferId == 0)
+    {
+        return;
+    }
+
+    // A persistent mapping has to be released before the buffer.
+    if (block.mapping != NULL)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, block.bufferId);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        block.mapping = NULL;
+    }
+
+    // The GL keeps the storage alive for draws still reading it.
+    glDeleteBuffers(1, &block.bufferId);
+
+    block.bufferId = 0;
+    block.freeRanges.clear();
+}
+
+void freeGpuBufferRange(GpuBufferRange& range)
+{
+    if (range.bufferId == 0)
+    {
+        return;
+    }
+
+    GpuBufferBlock& block = blocks[range.block];
+
+    usedBytes -= range.bytes;
+
+    if (block.dedicated == true)
+    {
+        deleteBlock(block);
+    }
+    else
+    {
+        RetiredRange retired;
+
+        retired.block = range.block;
+        retired.range = FreeRange{ range.offset, range.bytes };
+        retired.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        retiredRanges.push_back(retired);
+    }
+
+    range.bufferId = 0;
+    range.offset = 0;
+    range.bytes = 0;
+    range.mapping = NULL;
+    range.block = 0;
+}
+
+void freeGpuBufferArena()
+{
+    for (size_t i = 0; i < retiredRanges.size(); i++)
+    {
+        glDeleteSync(retiredRanges[i].fence);
+    }
+
+    retiredRanges.clear();
+
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        deleteBlock(blocks[i]);
+    }
+
+    blocks.clear();
+
+    usedBytes = 0;
+}
+
+GLsizeiptr getGpuBufferArenaBytes()
+{
+    GLsizeiptr bytes = 0;
+
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        if (blocks[i].bufferId != 0)
+        {
+            bytes += blocks[i].bytes;
+        }
+    }
+
+    return bytes;
+}
+
+GLsizeiptr getGpuBufferArenaUsedBytes()
+{
+    return usedBytes;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Smallest backing buffer the arena creates. A range that doesn't fit in one
+// gets a buffer of its own size.
+const GLsizeiptr gpuBufferBlockBytes = 32 << 20;
+
+// A range of one of the arena's backing buffers. Many ranges share a buffer,
+// so draws pick theirs out with a base vertex (or base instance) instead of
+// binding a buffer of their own.
+struct GpuBufferRange
+{
+    GLuint      bufferId;
+    GLintptr    offset;
+    GLsizeiptr  bytes;
+
+    // The range's first byte in the buffer's persistent mapping, in the
+    // persistent ring upload mode. NULL otherwise.
+    void*       mapping;
+
+    // Backing buffer index. Unallocated ranges have a bufferId of 0.
+    int         block;
+};
+
+// Suballocate bytes at an offset that is a multiple of alignment, which need
+// not be a power of two: vertex ranges align to the vertex stride, so their
+// base vertex is a whole number. Buffers are created for the current upload
+// mode. The map mode orphans whole buffers, so each of its ranges gets a
+// buffer of its own.
+bool allocateGpuBufferRange(GpuBufferRange& range, GLsizeiptr bytes, GLsizeiptr alignment);
+
+// Give a range back. It is only handed out again once the GPU has finished
+// the commands issued so far, which may still read it.
+void freeGpuBufferRange(GpuBufferRange& range);
+
+// Delete every backing buffer. Ranges still allocated become invalid.
+void freeGpuBufferArena();
+
+// Bytes of backing buffers, and of those the bytes allocated.
+GLsizeiptr getGpuBufferArenaBytes();
+
+GLsizeiptr getGpuBufferArenaUsedBytes();
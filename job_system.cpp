@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "job_system.h"
+
+struct Job
+{
+    JobFunction         function;
+    Job*                parent;
+
+    // This job plus its unfinished children.
+    std::atomic<int>    unfinishedJobs;
+
+    // Unfinished dependencies, plus one until runJob().
+    std::atomic<int>    pendingDependencies;
+
+    int                 continuationCount;
+    Job*                continuations[maxJobContinuations];
+
+    alignas(std::max_align_t) unsigned char data[jobDataBytes];
+};
+
+// A thread's queued jobs. The owner pushes and pops at the bottom, thieves take
+// from the top, so the owner works on what it queued last while thieves take
+// the oldest, and usually biggest, pieces of work.
+struct JobQueue
+{
+    std::mutex      mutex;
+    Job*            jobs[jobPoolSize];
+    int             top;
+    int             bottom;
+};
+
+// Arguments of one piece of a parallel for.
+struct ParallelForRange
+{
+    ParallelRangeFunction   function;
+    const void*             body;
+    int                     begin;
+    int                     end;
+    int                     grain;
+};
+
+static std::vector<std::thread>                 workers;
+static std::unique_ptr<JobQueue[]>              jobQueues;
+static int                                      jobThreadCount = 1;
+
+// Jobs queued over all threads, so idle workers know when to sleep.
+static std::atomic<int>                         queuedJobs(0);
+
+static std::mutex                               sleepMutex;
+static std::condition_variable                  jobQueued;
+static std::atomic<int>                         sleepingWorkers(0);
+static std::atomic<bool>                        stopping(false);
+
+// Yields before an idle worker goes to sleep. Work for the next frame phase
+// usually arrives sooner than a sleeping thread could be woken.
+const int workerSpinCount = 64;
+
+// Index of this thread's queue. Threads the job system didn't start share thread 0's.
+static thread_local int                         jobThreadIndex = 0;
+
+// Each thread creates jobs from its own ring, so creating one takes no lock.
+static thread_local std::unique_ptr<Job[]>      jobPool;
+static thread_local unsigned int                jobPoolNext = 0;
+
+static void pushJob(Job* job)
+{
+    JobQueue& queue = jobQueues[jobThreadIndex];
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        queue.jobs[queue.bottom % jobPoolSize] = job;
+        queue.bottom++;
+    }
+
+    queuedJobs.fetch_add(1);
+
+    if (sleepingWorkers.load() > 0)
+    {
+        // Taking the mutex orders this with a worker between checking for jobs and sleeping.
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+
+        jobQueued.notify_one();
+    }
+}
+
+static Job* popJob(JobQueue& queue)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.bottom == queue.top)
+    {
+        return NULL;
+    }
+
+    queue.bottom--;
+
+    return queue.jobs[queue.bottom % jobPoolSize];
+}
+
+static Job* stealJob(JobQueue& queue)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.bottom == queue.top)
+    {
+        return NULL;
+    }
+
+    Job* job = queue.jobs[queue.top % jobPoolSize];
+
+    queue.top++;
+
+    return job;
+}
+
+// This thread's newest job, or else the oldest of another thread's.
+static Job* getJob()
+{
+    if (queuedJobs.load() == 0)
+    {
+        return NULL;
+    }
+
+    Job* job = popJob(jobQueues[jobThreadIndex]);
+
+    for (int i = 1; i < jobThreadCount && job == NULL; i++)
+    {
+        job = stealJob(jobQueues[(jobThreadIndex + i) % jobThreadCount]);
+    }
+
+    if (job != NULL)
+    {
+        queuedJobs.fetch_sub(1);
+    }
+
+    return job;
+}
+
+static void finishJob(Job* job)
+{
+    // Once it counts as finished, a waiter may move on and the slot be reused,
+    // so read everything needed afterwards first.
+    Job* parent = job->parent;
+
+    int continuationCount = job->continuationCount;
+
+    Job* continuations[maxJobContinuations];
+
+    for (int i = 0; i < continuationCount; i++)
+    {
+        continuations[i] = job->continuations[i];
+    }
+
+    if (job->unfinishedJobs.fetch_sub(1) != 1)
+    {
+        return;
+    }
+
+    for (int i = 0; i < continuationCount; i++)
+    {
+        if (continuations[i]->pendingDependencies.fetch_sub(1) == 1)
+        {
+            pushJob(continuations[i]);
+        }
+    }
+
+    if (parent != NULL)
+    {
+        finishJob(parent);
+    }
+}
+
+static void executeJob(Job* job)
+{
+    job->function(job, job->data);
+
+    finishJob(job);
+}
+
+static void workerMain(int threadIndex)
+{
+    jobThreadIndex = threadIndex;
+
+    int idleSpins = 0;
+
+    while (stopping.load() == false)
+    {
+        Job* job = getJob();
+
+        if (job != NULL)
+        {
+            executeJob(job);
+
+            idleSpins = 0;
+
+            continue;
+        }
+
+        if (idleSpins++ < workerSpinCount)
+        {
+            std::this_thread::yield();
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+
+        sleepingWorkers.fetch_add(1);
+
+        jobQueued.wait(lock, [] { return queuedJobs.load() > 0 || stopping.load() == true; });
+
+        sleepingWorkers.fetch_sub(1);
+
+        idleSpins = 0;
+    }
+}
+
+void initJobSystem(int threadCount)
+{
+    shutdownJobSystem();
+
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    jobThreadCount = threadCount;
+
+    jobQueues.reset(new JobQueue[threadCount]);
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        jobQueues[i].top = 0;
+        jobQueues[i].bottom = 0;
+    }
+
+    queuedJobs = 0;
+    stopping = false;
+
+    jobThreadIndex = 0;
+
+    for (int i = 1; i < threadCount; i++)
+    {
+        workers.push_back(std::thread(workerMain, i));
+    }
+}
+
+void shutdownJobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+
+        stopping = true;
+    }
+
+    jobQueued.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+
+    workers.clear();
+
+    jobThreadCount = 1;
+}
+
+int getJobThreadCount()
+{
+    return jobThreadCount;
+}
+
+Job* createJob(JobFunction function, const void* data, size_t bytes, Job* parent)
+{
+    if (jobPool == NULL)
+    {
+        jobPool.reset(new Job[jobPoolSize]);
+    }
+
+    Job* job = &jobPool[jobPoolNext % jobPoolSize];
+
+    jobPoolNext++;
+
+    job->function = function;
+    job->parent = parent;
+    job->unfinishedJobs = 1;
+    job->pendingDependencies = 1;
+    job->continuationCount = 0;
+
+    memcpy(job->data, data, std::min<size_t>(bytes, jobDataBytes));
+
+    if (parent != NULL)
+    {
+        parent->unfinishedJobs.fetch_add(1);
+    }
+
+    return job;
+}
+
+void jobDependsOn(Job* job, Job* dependency)
+{
+    if (dependency->continuationCount >= maxJobContinuations)
+    {
+        // Out of slots: the job can't be told when to run, so wait here instead.
+        runJob(dependency);
+
+        waitForJob(dependency);
+
+        return;
+    }
+
+    job->pendingDependencies.fetch_add(1);
+
+    dependency->continuations[dependency->continuationCount++] = job;
+}
+
+void runJob(Job* job)
+{
+    if (job->pendingDependencies.fetch_sub(1) == 1)
+    {
+        pushJob(job);
+    }
+}
+
+void waitForJob(Job* job)
+{
+    while (job->unfinishedJobs.load() > 0)
+    {
+        Job* next = getJob();
+
+        if (next != NULL)
+        {
+            executeJob(next);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static void parallelForJob(Job* job, const void* data)
+{
+    ParallelForRange range = *static_cast<const ParallelForRange*>(data);
+
+    // Hand the upper half to a child others can steal, and keep splitting the lower.
+    while (range.end - range.begin > range.grain)
+    {
+        ParallelForRange upper = range;
+
+        upper.begin = range.begin + (range.end - range.begin) / 2;
+
+        runJob(createJob(parallelForJob, &upper, sizeof(upper), job));
+
+        range.end = upper.begin;
+    }
+
+    range.function(range.body, range.begin, range.end);
+}
+
+Job* createParallelForJob(int count, int grain, ParallelRangeFunction function, const void* body, Job* parent)
+{
+    ParallelForRange range;
+
+    range.function = function;
+    range.body = body;
+    range.begin = 0;
+    range.end = std::max(0, count);
+
+    // Enough pieces for stealing to even out the threads, without one job per item.
+    range.grain = std::max(std::max(1, grain), count / (8 * jobThreadCount));
+
+    return createJob(parallelForJob, &range, sizeof(range), parent);
+}
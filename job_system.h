@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+// Bytes of arguments a job carries, copied in by createJob().
+const int jobDataBytes = 64;
+
+// Jobs each thread can create before its pool wraps around and reuses the
+// oldest. Every job a thread created that many jobs ago must have finished.
+const int jobPoolSize = 4096;
+
+// Jobs that can wait on one job with jobDependsOn().
+const int maxJobContinuations = 8;
+
+struct Job;
+
+typedef void (*JobFunction)(Job* job, const void* data);
+
+// Start threadCount - 1 worker threads, or one per hardware thread when
+// threadCount is 0. The calling thread is thread 0: it owns the GL context and
+// runs jobs only while it waits in waitForJob(). Jobs must not call the GL.
+void initJobSystem(int threadCount);
+
+void shutdownJobSystem();
+
+// Threads that run jobs, the calling thread included.
+int getJobThreadCount();
+
+// A job that calls function with a copy of data once run. While it runs it may
+// create children of itself; it only counts as finished when they all have.
+// A parent must not be finished yet.
+Job* createJob(JobFunction function, const void* data, size_t bytes, Job* parent = NULL);
+
+// Wrap a lambda, which is copied into the job, so it may only capture what fits.
+template<typename Function>
+Job* createJob(const Function& function, Job* parent = NULL)
+{
+    static_assert(sizeof(Function) <= jobDataBytes, "Job captures too much");
+    static_assert(std::is_trivially_copyable<Function>::value, "Job captures must be trivially copyable");
+
+    return createJob([](Job*, const void* data) { (*static_cast<const Function*>(data))(); }, &function, sizeof(Function), parent);
+}
+
+// Hold job back until dependency has finished. Both must not have been run yet.
+void jobDependsOn(Job* job, Job* dependency);
+
+// Queue the job on this thread's deque, or, if it has dependencies left, leave it
+// for the last of them to queue. Idle threads steal from the other end.
+void runJob(Job* job);
+
+// Run queued jobs, this thread's own first, until job and its children have finished.
+void waitForJob(Job* job);
+
+typedef void (*ParallelRangeFunction)(const void* body, int begin, int end);
+
+Job* createParallelForJob(int count, int grain, ParallelRangeFunction function, const void* body, Job* parent = NULL);
+
+// A job calling body(begin, end) over [0, count). It splits the range in
+// halves, stealable by other threads, until they are no bigger than about
+// count / (8 * threads) items, but no fewer than grain. Bodies must only write
+// their own items, and must live until the job has finished.
+template<typename Body>
+Job* createParallelForJob(int count, int grain, const Body& body, Job* parent = NULL)
+{
+    return createParallelForJob(count, grain, [](const void* context, int begin, int end) { (*static_cast<const Body*>(context))(begin, end); }, &body, parent);
+}
+
+// Run a parallel for job and wait for it. Runs inline on one thread or for a single range.
+template<typename Body>
+void parallelFor(int count, int grain, const Body& body)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    if (getJobThreadCount() == 1 || count <= grain)
+    {
+        body(0, count);
+
+        return;
+    }
+
+    Job* job = createParallelForJob(count, grain, body);
+
+    runJob(job);
+
+    waitForJob(job);
+}
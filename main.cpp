@@ -1,647 +1,470 @@
-#if 0 // toggle on/off
-
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
 
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
 #include <GL/glew.h>
-#include <GL/freeglut.h>
-#include <GL/gl.h>
-#include <GL/glu.h>
-
-#include "SDL.h"
-
-#define main SDL_main
-
-// Alert and return if GL error
-#define RETURN_IF_GL_ERROR(F) RETURN_IF_GL_ERROR2("Function " F " failed with error")
-#define RETURN_IF_GL_ERROR2(M) { GLenum error = glGetError(); if (error != GL_NO_ERROR) { std::cout<< M ": " << gluErrorString(error) << std::endl; return false; } }
-
-SDL_Window*     window;
-SDL_Surface*    screen;
-SDL_Renderer*   sdlRenderer;
-SDL_GLContext   openGlContext;
-
-int             screenWidth = 1280;
-int             screenHeight = 720;
 
-glm::mat4       projectionMatrix;
-GLint           projectionMatrixLocation;
-
-glm::mat4       modelViewMatrix;
-GLint           modelViewMatrixLocation;
-
-GLint           texUnitLocation;
-
-GLuint          textureId;
-
-struct VertexPos3D
-{
-	GLfloat x;
-	GLfloat y;
-	GLfloat z;
+#include "asset_pack.h"
+#include "baked_texture.h"
+#include "benchmark.h"
+#include "camera.h"
+#include "frame_arena.h"
+#include "job_system.h"
+#include "mipmaps.h"
+#include "profiler.h"
+#include "quad_groups.h"
+#include "quad_transform.h"
+#include "render_path.h"
+#include "render_thread.h"
+#include "screen.h"
+#include "testbed.h"
+#include "texture_cache.h"
+#include "texture_loader.h"
+
+RenderPath* renderPaths[] = {
+    &singleQuadPath,
+    &renderToTexturePath,
+    &silhouetteBufferPath,
+    &integerTexturePath
 };
 
-struct VertexData3D
-{
-	VertexPos3D	pos;
-};
+const int renderPathCount = sizeof(renderPaths) / sizeof(renderPaths[0]);
 
-struct Shader
+void printUsage(const char* program)
 {
-	GLuint                      programId;
-	GLuint                      vertexBufferId;
-	GLuint                      indexBufferId;
-	int                         vertexBufferSize;
-	std::vector<VertexData3D>   vertexData;
-	std::vector<GLuint>         indexData;
-	GLuint                      texturedQuadVao;
-	GLint                       vertexPos2dLocation;
-};
-
-Shader shader;
-
-void addQuad()
-{
-	int quadSize = 256;
-
-	//Set vertex data
-	VertexData3D vData[4];
-
-	// Position
-	vData[0].pos.x = (screenWidth / 2) - (quadSize / 2);
-	vData[0].pos.y = (screenHeight / 2) - (quadSize / 2);
-	vData[0].pos.z = 0.0f;
-
-	vData[1].pos.x = (screenWidth / 2) + (quadSize / 2);
-	vData[1].pos.y = vData[0].pos.y;
-	vData[1].pos.z = 0.0f;
-
-	vData[2].pos.x = vData[1].pos.x;
-	vData[2].pos.y = (screenHeight / 2) + (quadSize / 2);
-	vData[2].pos.z = 0.0f;
-
-	vData[3].pos.x = vData[0].pos.x;
-	vData[3].pos.y = vData[2].pos.y;
-	vData[3].pos.z = 0.0f;
-
-	int vertexCount = shader.vertexData.size();
-
-	shader.indexData.push_back(vertexCount);
-	shader.indexData.push_back(vertexCount + 1);
-	shader.indexData.push_back(vertexCount + 2);
-	shader.indexData.push_back(vertexCount + 3);
-
-	shader.vertexData.push_back(vData[0]);
-	shader.vertexData.push_back(vData[1]);
-	shader.vertexData.push_back(vData[2]);
-	shader.vertexData.push_back(vData[3]);
-}
-
-bool loadBufferIntoTexture(GLint* buffer, size_t size, int width, int height, GLuint& textureId)
-{
-	// Generate texture ID
-	glGenTextures(1, &textureId);
-
-	RETURN_IF_GL_ERROR("glGenTextures");
-
-	// Bind texture ID
-	glActiveTexture(GL_TEXTURE0);
-
-	glBindTexture(GL_TEXTURE_RECTANGLE, textureId);
-
-	glTexImage2D(
-		GL_TEXTURE_RECTANGLE,
-		0,
-		GL_RGBA32I,
-		width,
-		height,
-		0,
-		GL_RGBA_INTEGER,
-		GL_INT,
-		(GLuint*)buffer);
-
-	RETURN_IF_GL_ERROR("glTexImage2D")
-
-	//Set texture parameters
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-
-	//Unbind texture
-	glBindTexture(GL_TEXTURE_RECTANGLE, NULL);
-
-	return true;
-}
-
-bool createTexture()
-{
-	GLint glintMax = std::numeric_limits<GLint>::max();
-
-	// 3x1 texture with a red, green, and blue pixel.
-	GLint buffer[12] = { 
-		glintMax, 0,        0,        glintMax, // Red
-		0,        glintMax, 0,        glintMax, // Green
-		0,        0,        glintMax, glintMax  // Blue
-	};
-
-	bool texLoaded = loadBufferIntoTexture(buffer, 12, 3, 1, textureId);
-
-	return texLoaded;
-}
-
-void freeVbo()
-{
-	//Free VBO and IBO
-	if (shader.vertexBufferId != 0)
-	{
-		glDeleteBuffers(1, &shader.vertexBufferId);
-		glDeleteBuffers(1, &shader.indexBufferId);
-
-		shader.vertexBufferId = 0;
-		shader.indexBufferId = 0;
-	}
-}
-
-void freeVao()
-{
-	if (shader.texturedQuadVao != 0)
-	{
-		glDeleteVertexArrays(1, &shader.texturedQuadVao);
+    std::cout << "Usage: " << program << " [--path <name>|all] [--headless] [--frames <n>] [--capture <file.ppm>] [--profile] [--trace <file.json>]" << std::endl;
+    std::cout << "           [--upload subdata|ring|map] [--no-upload-hash] [--instanced] [--retained] [--group-draws] [--cull]" << std::endl;
+    std::cout << "           [--vertex-format float|compact|packed] [--transform-kernel auto|scalar|sse2|avx2] [--threads <n>] [--render-thread]" << std::endl;
+    std::cout << "           [--camera <x,y,zoom,degrees>] [--async-textures] [--assets <file.pack>] [--baked-textures]" << std::endl;
+    std::cout << "           [--texture-budget <MiB>] [--mipmaps]" << std::endl;
+    std::cout << "       " << program << " --benchmark [--path <name>|all] [--quads <n,n,...>] [--seed <n>] [--warmup <n>] [--frames <n>]" << std::endl;
+    std::cout << "           [--group-size <n>] [--scale <min,max>] [--rotation <degrees>] [--world <n>] [--pan <pixels>]" << std::endl;
+    std::cout << "           [--mutate <percent>] [--group-changes <frames>] [--json <file>]" << std::endl;
+    std::cout << "       " << program << " --verify-transform [--quads <n,n,...>] [--seed <n>] [--scale <min,max>] [--rotation <degrees>]" << std::endl;
+    std::cout << "       " << program << " --pack <file.pack> <file> [<file>...]" << std::endl;
+    std::cout << "       " << program << " [--mipmaps] [--texture-compression none|bc1|bc3] [--threads <n>] --bake <image> [<image>...]" << std::endl;
+    std::cout << "Render paths:";
+
+    for (int i = 0; i < renderPathCount; i++)
+    {
+        std::cout << " " << renderPaths[i]->name;
+    }
 
-		shader.texturedQuadVao = 0;
-	}
+    std::cout << std::endl;
 }
 
-GLuint createShaders()
+// Run one render path until the frame limit is hit or the window is closed.
+bool runPath(RenderPath& path)
 {
-	// Read the code for the shaders into strings.
-	std::string vertexShaderCode = R"V0G0N(
-#version 330 core
-
-//Transformation Matrices
-uniform mat4 projectionMatrix;
-uniform mat4 modelViewMatrix;
-
-in vec3 vertexPos3D;
-
-void main() 
-{  
-    gl_Position = projectionMatrix * modelViewMatrix * vec4(vertexPos3D.x, vertexPos3D.y, vertexPos3D.z, 1.0);
-}
-)V0G0N";
-
-
-	std::string fragmentShaderCode = R"V0G0N(
-#version 330 core
+    if (path.init() == false)
+    {
+        std::cout << "Render path '" << path.name << "' initialization failed" << std::endl;
 
-out vec4 fragColor;
+        path.shutdown();
 
-uniform isampler2DRect textureUnit;
+        return false;
+    }
 
-in vec4 gl_FragCoord;
+    bool quit = false;
 
-void main() 
-{
-    // Coordinates of the red pixel.
-    vec2 texCoords = vec2(0, 0);
+    int frameCount = 0;
 
-    vec4 textureSample = texture(textureUnit, texCoords);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-    fragColor = textureSample;
+    resetProfiler();
 
-    if (textureSample.r == 2147483584 && textureSample.r == 2147483647)
+    if (startRenderThread() == false)
     {
-        vec4 blue = vec4(0.0, 0.0, 1.0, 1.0); 
+        path.shutdown();
 
-            // Mix with blue to provide visual output that the case was hit.
-        fragColor = mix(fragColor, blue, 0.5);
+        return false;
     }
-}
-)V0G0N";
 
-	// Create the shaders
-	GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
-	GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
+    while (quit == false)
+    {
+        resetFrameArena();
 
-	GLint Result = GL_FALSE;
-	int InfoLogLength;
+        // A trace grows every frame, so only frames without one have to stay off the heap.
+        // Nor can frames while textures load, whose loader threads allocate.
+        bool checkAllocations = (frameCount >= allocationCheckWarmupFrames && profilerTracing() == false && getPendingTextureLoadCount() == 0);
 
-	// Compile Vertex Shader
-	char const* vertexSourcePointer = vertexShaderCode.c_str();
-	glShaderSource(vertexShaderId, 1, &vertexSourcePointer, NULL);
-	glCompileShader(vertexShaderId);
+        beginAllocationCheck();
 
-	// Check Vertex Shader
-	glGetShaderiv(vertexShaderId, GL_COMPILE_STATUS, &Result);
+        // With a render thread, this waits until it has drawn the frame before last.
+        beginRenderCommands();
 
-	glGetShaderiv(vertexShaderId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+        recordBeginProfilerFrame();
 
-	if (InfoLogLength > 0)
-	{
-		std::vector<char> vertexShaderErrorMessage(InfoLogLength);
+        recordUpdateTextureLoads();
 
-		glGetShaderInfoLog(vertexShaderId, InfoLogLength, NULL, &vertexShaderErrorMessage[0]);
+        // Loads the render thread uploaded last frame reach the texture cache here.
+        callTextureLoadedFunctions();
 
-		std::cout << &vertexShaderErrorMessage[0] << std::endl;
-	}
+        recordBindFramebuffer(screenFrameBufferId);
 
-	// Compile Fragment Shader
-	char const* fragmentSourcePointer = fragmentShaderCode.c_str();
-	glShaderSource(fragmentShaderId, 1, &fragmentSourcePointer, NULL);
-	glCompileShader(fragmentShaderId);
+        // Init the scene.
+        recordClear(0.0f, 0.0f, 0.0f, 0.0f, GL_COLOR_BUFFER_BIT);
 
-	// Check Fragment Shader
-	glGetShaderiv(fragmentShaderId, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(fragmentShaderId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+        beginMainThreadProfileScope("poll");
 
-	if (InfoLogLength > 0)
-	{
-		std::vector<char> fragmentShaderErrorMessage(InfoLogLength);
-		glGetShaderInfoLog(fragmentShaderId, InfoLogLength, NULL, &fragmentShaderErrorMessage[0]);
-		std::cout << &fragmentShaderErrorMessage[0] << std::endl;
-	}
+        if (pollQuitEvent() == true)
+        {
+            quit = true;
+        }
 
-	// Link
-	GLuint programId = glCreateProgram();
-	glAttachShader(programId, vertexShaderId);
-	glAttachShader(programId, fragmentShaderId);
-	glLinkProgram(programId);
+        endMainThreadProfileScope();
 
-	// Check the program
-	glGetProgramiv(programId, GL_LINK_STATUS, &Result);
-	glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+        beginMainThreadProfileScope("buildScene");
 
-	if (InfoLogLength > 0)
-	{
-		std::vector<char> programErrorMessage(std::max(InfoLogLength, int(1)));
-		glGetProgramInfoLog(programId, InfoLogLength, NULL, &programErrorMessage[0]);
-		std::cout << &programErrorMessage[0] << std::endl;
-	}
+        // Retained quads stay in the shader, so a static scene is only built once.
+        if (retainedQuads == false || frameCount == 0)
+        {
+            path.buildScene();
+        }
 
-	glDeleteShader(vertexShaderId);
-	glDeleteShader(fragmentShaderId);
+        endMainThreadProfileScope();
 
-	return programId;
-}
+        recordBeginProfileScope("renderFrame");
 
-bool initOpenGl()
-{
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        path.renderFrame();
 
-	openGlContext = SDL_GL_CreateContext(window);
+        recordEndProfileScope();
 
-	if (openGlContext == NULL)
-	{
-		std::cout << "OpenGL context creation failed with error: " << SDL_GetError() << std::endl;
-	}
+        recordBeginProfileScope("present");
 
-	//Initialize GLEW
-	GLenum glewError = glewInit();
+        recordPresent();
 
-	if (glewError != GLEW_OK)
-	{
-		std::cout << "Error initializing GLEW: " << glewGetErrorString(glewError) << std::endl;
-		return false;
-	}
+        recordEndProfileScope();
 
-	//Make sure OpenGL 2.1 is supported
-	if (!GLEW_VERSION_2_1)
-	{
-		std::cout << "OpenGL 2.1 not supported" << std::endl;
-		return false;
-	}
+        recordEndProfilerFrame();
 
-	std::cout << "GLEW version: " << glewGetString(GLEW_VERSION) << std::endl;
+        submitRenderCommands();
 
-	//Set the viewport
-	glViewport(0.f, 0.f, screenWidth, screenHeight);
+        if (checkAllocations == true)
+        {
+            endAllocationCheck(path.name, frameCount);
+        }
 
-	//Initialize clear color
-	glClearColor(0.f, 0.f, 0.f, 1.f);
+        frameCount++;
 
-	//Enable texturing
-	glEnable(GL_TEXTURE_RECTANGLE);
+        if (frameLimit > 0 && frameCount >= frameLimit)
+        {
+            quit = true;
+        }
+    }
 
-	//Set blending
-	glEnable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    finishRenderCommands();
 
-	//Check for error
-	GLenum error = glGetError();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
 
-	if (error != GL_NO_ERROR)
-	{
-		std::cout << "OpenGL renderer initialization failed with error: " << gluErrorString(error) << std::endl;
+    stopRenderThread();
 
-		return false;
-	}
+    std::cout << path.name << ": " << frameCount << " frames, " << elapsed.count() / frameCount << " ms/frame" << std::endl;
 
-	std::cout << "OpenGL version " << glGetString(GL_VERSION) << std::endl;
-	std::cout << "GLSL version " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
+    if (profilerEnabled == true)
+    {
+        printProfileReport();
+    }
 
-	return true;
+    path.shutdown();
+
+    return true;
 }
 
-bool initializeScreen()
+int main(int argc, char* argv[])
 {
-	if (window != NULL)
-	{
-		SDL_DestroyWindow(window);
-	}
+    parseScreenArgs(argc, argv);
 
-	// Create the window via SDL
-	window = SDL_CreateWindow("Untitled Game - Firemelon Engine",
-		SDL_WINDOWPOS_CENTERED,
-		SDL_WINDOWPOS_CENTERED,
-		screenWidth,
-		screenHeight,
-		SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL);
+    BenchmarkSettings benchmarkSettings;
 
+    parseBenchmarkArgs(argc, argv, benchmarkSettings);
 
-	if (window == NULL)
-	{
-		std::cout << "Window creation failed with error: " << SDL_GetError() << std::endl;
+    // A benchmark compares every path unless told otherwise.
+    std::string pathName = benchmarkSettings.enabled ? "all" : "single-quad";
 
-		return false;
-	}
+    std::string traceFilename;
 
-	SDL_ShowCursor(1);
+    bool verifyTransform = false;
 
-	screen = SDL_GetWindowSurface(window);
+    std::string assetPackFilename;
 
-	if (screen == nullptr)
-	{
-		return false;
-	}
+    // With --pack, the pack to write and the files to put in it.
+    std::string packFilename;
 
-	// Create the renderer.
-	sdlRenderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    std::vector<std::string> packFiles;
 
-	if (sdlRenderer == nullptr)
-	{
-		std::cout << "Renderer creation failed with error: " << SDL_GetError() << std::endl;
+    // With --bake, the images to bake.
+    std::vector<std::string> bakeFiles;
 
-		return false;
-	}
+    // Zero uses every hardware thread.
+    int threadCount = 0;
 
-	if (initOpenGl() == false)
-	{
-		return false;
-	}
-
-	return true;
-}
-
-bool initVbo()
-{
-	if (shader.vertexBufferId == 0)
-	{
-		// Start with a buffer size of 500. Re-allocate a larger buffer if
-		// it becomes necessary later.
-		VertexData3D vData[500];
-		GLuint iData[500];
-
-		//Create VBO
-		glGenBuffers(1, &shader.vertexBufferId);
-		glBindBuffer(GL_ARRAY_BUFFER, shader.vertexBufferId);
-		glBufferData(GL_ARRAY_BUFFER, 500 * sizeof(VertexData3D), vData, GL_DYNAMIC_DRAW);
-
-		//Check for error
-		GLenum error = glGetError();
-
-		if (error != GL_NO_ERROR)
-		{
-			std::cout << "Error creating vertex buffer: " << gluErrorString(error) << std::endl;
-			return false;
-		}
-
-		//Create IBO
-		glGenBuffers(1, &shader.indexBufferId);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shader.indexBufferId);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, 500 * sizeof(GLuint), iData, GL_DYNAMIC_DRAW);
-
-		//Check for error
-		error = glGetError();
-
-		if (error != GL_NO_ERROR)
-		{
-			std::cout << "Error creating vertex index buffer: " << gluErrorString(error) << std::endl;
-			return false;
-		}
-
-		//Unbind buffers
-		glBindBuffer(GL_ARRAY_BUFFER, NULL);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, NULL);
-	}
-
-	return true;
-}
-
-bool initShaders()
-{
-	GLenum error;
-
-	shader.programId = createShaders();
-
-	glUseProgram(shader.programId);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--path") == 0 && i + 1 < argc)
+        {
+            pathName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            profilerEnabled = true;
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            traceFilename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--upload") == 0 && i + 1 < argc)
+        {
+            if (setUploadMode(argv[++i]) == false)
+            {
+                std::cout << "Unknown upload mode '" << argv[i] << "'" << std::endl;
+
+                printUsage(argv[0]);
+
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--instanced") == 0)
+        {
+            instancedQuads = true;
+        }
+        else if (strcmp(argv[i], "--retained") == 0)
+        {
+            retainedQuads = true;
+        }
+        else if (strcmp(argv[i], "--group-draws") == 0)
+        {
+            groupedDraws = true;
+        }
+        else if (strcmp(argv[i], "--camera") == 0 && i + 1 < argc)
+        {
+            Camera2D camera = getCamera();
+
+            sscanf(argv[++i], "%f,%f,%f,%f", &camera.x, &camera.y, &camera.zoom, &camera.rotationDegrees);
+
+            setCamera(camera);
+        }
+        else if (strcmp(argv[i], "--async-textures") == 0)
+        {
+            asyncTextureLoading = true;
+        }
+        else if (strcmp(argv[i], "--cull") == 0)
+        {
+            viewportCulling = true;
+        }
+        else if (strcmp(argv[i], "--no-upload-hash") == 0)
+        {
+            skipUnchangedUploads = false;
+        }
+        else if (strcmp(argv[i], "--vertex-format") == 0 && i + 1 < argc)
+        {
+            if (setVertexFormat(argv[++i]) == false)
+            {
+                std::cout << "Unknown vertex format '" << argv[i] << "'" << std::endl;
+
+                printUsage(argv[0]);
+
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--transform-kernel") == 0 && i + 1 < argc)
+        {
+            if (setTransformKernel(argv[++i]) == false)
+            {
+                std::cout << "Unknown or unsupported transform kernel '" << argv[i] << "'" << std::endl;
+
+                printUsage(argv[0]);
+
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threadCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--render-thread") == 0)
+        {
+            renderThreadEnabled = true;
+        }
+        else if (strcmp(argv[i], "--verify-transform") == 0)
+        {
+            verifyTransform = true;
+        }
+        else if (strcmp(argv[i], "--assets") == 0 && i + 1 < argc)
+        {
+            assetPackFilename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+        {
+            textureCacheBudgetBytes = (size_t)atoi(argv[++i]) << 20;
+        }
+        else if (strcmp(argv[i], "--baked-textures") == 0)
+        {
+            bakedTextures = true;
+        }
+        else if (strcmp(argv[i], "--mipmaps") == 0)
+        {
+            textureMipmaps = true;
+        }
+        else if (strcmp(argv[i], "--texture-compression") == 0 && i + 1 < argc)
+        {
+            if (setBakedTextureCompression(argv[++i]) == false)
+            {
+                std::cout << "Unknown texture compression '" << argv[i] << "'" << std::endl;
+
+                printUsage(argv[0]);
+
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--bake") == 0 && i + 1 < argc)
+        {
+            // Every argument after it is an image to bake.
+            while (i + 1 < argc)
+            {
+                bakeFiles.push_back(argv[++i]);
+            }
+        }
+        else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc)
+        {
+            // Every argument after the pack's name is a file to put in it.
+            packFilename = argv[++i];
+
+            while (i + 1 < argc)
+            {
+                packFiles.push_back(argv[++i]);
+            }
+        }
+        else if (strcmp(argv[i], "--help") == 0)
+        {
+            printUsage(argv[0]);
+
+            return 0;
+        }
+    }
 
-	shader.vertexPos2dLocation = glGetAttribLocation(shader.programId, "vertexPos3D");
-	
-	projectionMatrixLocation = glGetUniformLocation(shader.programId, "projectionMatrix");
-	modelViewMatrixLocation = glGetUniformLocation(shader.programId, "modelViewMatrix");
-	texUnitLocation = glGetUniformLocation(shader.programId, "textureUnit");
+    // Decoding needs no context either.
+    if (bakeFiles.empty() == false)
+    {
+        bool ok = initImageLoader();
 
-	// Initialize the projection matrix
-	projectionMatrix = glm::ortho<GLfloat>(0.0, screenWidth, screenHeight, 0.0, 1.0, -1.0);
-	glUniformMatrix4fv(projectionMatrixLocation, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+        // Mips and blocks are filtered and encoded over the job threads.
+        initJobSystem(threadCount);
 
-	//Initialize modelview
-	modelViewMatrix = glm::mat4();
-	glUniformMatrix4fv(modelViewMatrixLocation, 1, GL_FALSE, glm::value_ptr(modelViewMatrix));
+        for (size_t i = 0; i < bakeFiles.size() && ok == true; i++)
+        {
+            ok &= bakeTexture(bakeFiles[i]);
+        }
 
-	glUniform1i(texUnitLocation, 0);
+        shutdownJobSystem();
 
-	RETURN_IF_GL_ERROR2("Error setting texture location");
-	
-	// Initialize the vertex buffer and index buffer objects that
-	// will be used to render the quads.
-	bool vboInitOk = initVbo();
+        return ok ? 0 : 1;
+    }
 
-	if (vboInitOk == false)
-	{
-		return false;
-	}
+    if (packFilename.empty() == false)
+    {
+        return writeAssetPack(packFilename, packFiles) ? 0 : 1;
+    }
 
-	//Generate textured quad VAO
-	glGenVertexArrays(1, &shader.texturedQuadVao);
+    // Only needs the CPU, so it runs before any context is created.
+    if (verifyTransform == true)
+    {
+        bool ok = true;
 
-	//Bind vertex array
-	glBindVertexArray(shader.texturedQuadVao);
+        std::vector<QuadParams> quads;
 
-	RETURN_IF_GL_ERROR2("Error binding vertex array");
+        for (size_t i = 0; i < benchmarkSettings.quadCounts.size(); i++)
+        {
+            generateScene(quads, benchmarkSettings.quadCounts[i], benchmarkSettings);
 
-	// Enable vertex attributes.
-	glEnableVertexAttribArray(shader.vertexPos2dLocation);
+            ok &= verifyTransformKernels(quads);
+        }
 
-	RETURN_IF_GL_ERROR2("Error enabling vertex attribute 'Position'");
+        return ok ? 0 : 1;
+    }
 
-	//Set vertex data
-	glBindBuffer(GL_ARRAY_BUFFER, shader.vertexBufferId);
+    bool pathFound = (pathName == "all");
 
-	glVertexAttribPointer(shader.vertexPos2dLocation,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		sizeof(VertexData3D),
-		(GLvoid*)offsetof(VertexData3D, pos));
+    for (int i = 0; i < renderPathCount; i++)
+    {
+        pathFound |= (pathName == renderPaths[i]->name);
+    }
 
-	RETURN_IF_GL_ERROR2("Error setting vertex data")
-	
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shader.indexBufferId);
+    if (pathFound == false)
+    {
+        std::cout << "Unknown render path '" << pathName << "'" << std::endl;
 
-	//Unbind VAO
-	glBindVertexArray(NULL);
+        printUsage(argv[0]);
 
-	return true;
-}
+        return 1;
+    }
 
-void updateVbo()
-{
-	// Update the VBO contents. If the size of the array has increased, allocate a new VBO.
-	// Otherwise update the current VBO with the vertex data for this frame.
-	int size = shader.vertexData.size();
-
-	if (size > 0)
-	{
-		VertexData3D* vData = &shader.vertexData[0];
-		GLuint* iData = &shader.indexData[0];
-
-		if (size > shader.vertexBufferSize)
-		{
-			// Allocate a new VBO and IBO to fit the new data size.
-			shader.vertexBufferSize = size;
-
-			// Destroy the old VBO and IBO
-			freeVbo();
-
-			//Create new VBO
-			glGenBuffers(1, &shader.vertexBufferId);
-			glBindBuffer(GL_ARRAY_BUFFER, shader.vertexBufferId);
-			glBufferData(GL_ARRAY_BUFFER, size * sizeof(VertexData3D), vData, GL_DYNAMIC_DRAW);
-
-			//Create new IBO
-			glGenBuffers(1, &shader.indexBufferId);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shader.indexBufferId);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, size * sizeof(GLuint), iData, GL_DYNAMIC_DRAW);
-
-			// Bind the new VBO and IBO to the VAO.
-			glBindVertexArray(shader.texturedQuadVao);
-
-			//Set vertex data
-			glBindBuffer(GL_ARRAY_BUFFER, shader.vertexBufferId);
-
-			glVertexAttribPointer(shader.vertexPos2dLocation,
-				3,
-				GL_FLOAT,
-				GL_FALSE,
-				sizeof(VertexData3D),
-				(GLvoid*)offsetof(VertexData3D, pos));
-
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shader.indexBufferId);
-
-			//Unbind VAO
-			glBindVertexArray(NULL);
-
-			//Unbind buffers
-			glBindBuffer(GL_ARRAY_BUFFER, NULL);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, NULL);
-		}
-		else
-		{
-			// Bind vertex buffer.
-			glBindBuffer(GL_ARRAY_BUFFER, shader.vertexBufferId);
-
-			// Update vertex buffer data.
-			glBufferSubData(GL_ARRAY_BUFFER, 0, size * sizeof(VertexData3D), vData);
-
-			// Bind index buffer.
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shader.indexBufferId);
-
-			// Update index buffer.		
-			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size * sizeof(GLuint), iData);
-		}
-	}
-}
+    if (assetPackFilename.empty() == false && openAssetPack(assetPackFilename) == false)
+    {
+        return 1;
+    }
 
-int main(int argc, char* argv[])
-{
-	if (!initializeScreen()) { std::cout << "OpenGL Initialization Failed"  << std::endl; }
-	if (!initShaders())      { std::cout << "Shaders Initialization Failed" << std::endl; }
-	if (!createTexture())    { std::cout << "Texture Creation Failed"       << std::endl; }
-	 
-	bool quit = false;
+    // The main thread keeps the GL context; frame work fans out from it to the job threads.
+    initJobSystem(threadCount);
 
-	while (quit == false)
-	{
-		// Init the scene.
-		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    if (!initializeScreen()) { std::cout << "OpenGL Initialization Failed" << std::endl; return 1; }
+    if (!initImageLoader())  { std::cout << "Image Loader Initialization Failed" << std::endl; }
 
-		// Clear color buffer
-		glClear(GL_COLOR_BUFFER_BIT);
+    initTextureLoader();
 
-		shader.vertexData.clear();
-		shader.indexData.clear();
+    if (!initProfiler())     { std::cout << "Profiler Initialization Failed" << std::endl; }
 
-		SDL_Event event;
+    if (traceFilename.empty() == false)
+    {
+        beginProfilerTrace(traceFilename);
+    }
 
-		// While there's an event to handle...
-		while (SDL_PollEvent(&event))
-		{
-			switch (event.type)
-			{
-			case SDL_QUIT:
+    bool ok = true;
 
-				quit = true;
+    RenderPath* selectedPaths[renderPathCount];
 
-				break;
+    int selectedPathCount = 0;
 
-			default:
-				break;
-			}
-		}
+    for (int i = 0; i < renderPathCount; i++)
+    {
+        if (pathName == "all" || pathName == renderPaths[i]->name)
+        {
+            selectedPaths[selectedPathCount++] = renderPaths[i];
+        }
+    }
 
-		addQuad();
+    if (benchmarkSettings.enabled == true)
+    {
+        ok = runBenchmark(selectedPaths, selectedPathCount, benchmarkSettings);
+    }
+    else
+    {
+        // Every path runs on the same context and window, so the results are comparable.
+        for (int i = 0; i < selectedPathCount; i++)
+        {
+            ok &= runPath(*selectedPaths[i]);
+        }
+    }
 
-		GLuint vertexCount = shader.vertexData.size();
+    endProfilerTrace();
 
-		if (vertexCount > 0)
-		{
-			glUseProgram(shader.programId);
+    shutdownProfiler();
 
-			updateVbo();
+    freeTextureCache();
 
-			glActiveTexture(GL_TEXTURE0);
+    shutdownTextureLoader();
 
-			glBindTexture(GL_TEXTURE_RECTANGLE, textureId);
+    closeAssetPack();
 
-			glBindVertexArray(shader.texturedQuadVao);
+    shutdownScreen();
 
-			glDrawElements(GL_QUADS, vertexCount, GL_UNSIGNED_INT, NULL);
-			
-			glBindVertexArray(NULL);
-		}
+    shutdownJobSystem();
 
-		SDL_GL_SwapWindow(window);
-	}
+    freeFrameArena();
 
-	return 0;
+    return ok ? 0 : 1;
 }
-
-#endif
\ No newline at end of file
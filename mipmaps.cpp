@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdint>
+
+// SSE2 is part of x86-64, so it needs no check for support.
+#if defined(__x86_64__) || defined(_M_X64)
+#define MIPMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "job_system.h"
+#include "mipmaps.h"
+#include "testbed.h"
+
+bool            textureMipmaps = false;
+
+// Rows of the level below a job filters at least.
+static const int mipmapRowGrain = 16;
+
+int getMipLevelCount(int width, int height)
+{
+    int levelCount = 1;
+
+    for (int size = std::max(width, height); size > 1; size >>= 1)
+    {
+        levelCount++;
+    }
+
+    return levelCount;
+}
+
+int getMipLevelSize(int size, int level)
+{
+    return std::max(1, size >> level);
+}
+
+size_t getMipLevelBytes(int width, int height, int level)
+{
+    return (size_t)getMipLevelSize(width, level) * getMipLevelSize(height, level) * 4;
+}
+
+size_t getMipLevelOffset(int width, int height, int level)
+{
+    size_t offset = 0;
+
+    for (int i = 0; i < level; i++)
+    {
+        offset += getMipLevelBytes(width, height, i);
+    }
+
+    return offset;
+}
+
+size_t getMipChainBytes(int width, int height, int levelCount)
+{
+    return getMipLevelOffset(width, height, levelCount);
+}
+
+// Average the 2x2 source pixels under each pixel of rows [begin, end) of the level below.
+static void filterRows(const unsigned char* source, int sourceWidth, int sourceHeight, unsigned char* target, int targetWidth, int begin, int end)
+{
+    for (int y = begin; y < end; y++)
+    {
+        const unsigned char* row0 = source + (size_t)std::min(y * 2, sourceHeight - 1) * sourceWidth * 4;
+        const unsigned char* row1 = source + (size_t)std::min(y * 2 + 1, sourceHeight - 1) * sourceWidth * 4;
+
+        unsigned char* targetRow = target + (size_t)y * targetWidth * 4;
+
+        int x = 0;
+
+#ifdef MIPMAP_SSE2
+        // Two target pixels from four source pixels of each row. A source a
+        // pixel wide has no pairs to read, so it is left to the scalar loop.
+        int pairedWidth = (sourceWidth > 1) ? targetWidth : 0;
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+
+        for (; x + 2 <= pairedWidth; x += 2)
+        {
+            __m128i top = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+            __m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+            // Columns 0 and 1, then 2 and 3, summed down the two rows as 16 bit channels.
+            __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+            __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+            // Then across each pair.
+            __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+
+            __m128i average = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+
+            _mm_storel_epi64((__m128i*)(targetRow + x * 4), _mm_packus_epi16(average, zero));
+        }
+#endif
+
+        for (; x < targetWidth; x++)
+        {
+            int x0 = std::min(x * 2, sourceWidth - 1) * 4;
+            int x1 = std::min(x * 2 + 1, sourceWidth - 1) * 4;
+
+            for (int c = 0; c < 4; c++)
+            {
+                targetRow[x * 4 + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+void generateMipmaps(DecodedImage& image, bool parallel)
+{
+    int levelCount = getMipLevelCount(image.width, image.height);
+
+    int firstLevel = std::max(1, image.levelCount);
+
+    if (firstLevel >= levelCount)
+    {
+        return;
+    }
+
+    image.pixels.resize(getMipChainBytes(image.width, image.height, levelCount));
+
+    for (int level = firstLevel; level < levelCount; level++)
+    {
+        const unsigned char* source = image.pixels.data() + getMipLevelOffset(image.width, image.height, level - 1);
+        unsigned char* target = image.pixels.data() + getMipLevelOffset(image.width, image.height, level);
+
+        int sourceWidth = getMipLevelSize(image.width, level - 1);
+        int sourceHeight = getMipLevelSize(image.height, level - 1);
+
+        int targetWidth = getMipLevelSize(image.width, level);
+        int targetHeight = getMipLevelSize(image.height, level);
+
+        auto body = [=](int begin, int end)
+        {
+            filterRows(source, sourceWidth, sourceHeight, target, targetWidth, begin, end);
+        };
+
+        if (parallel == true)
+        {
+            parallelFor(targetHeight, mipmapRowGrain, body);
+        }
+        else
+        {
+            body(0, targetHeight);
+        }
+    }
+
+    image.levelCount = levelCount;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include "testbed.h"
+
+// When set, decoded images get a full mip chain before they are uploaded, or
+// baked, and are sampled trilinearly when drawn smaller than they are.
+extern bool            textureMipmaps;
+
+// Levels in a full chain down to 1x1.
+int getMipLevelCount(int width, int height);
+
+// Size of level level of a width x height image, never below 1.
+int getMipLevelSize(int size, int level);
+
+// Byte offset of a level in DecodedImage::pixels, and its bytes.
+size_t getMipLevelOffset(int width, int height, int level);
+
+size_t getMipLevelBytes(int width, int height, int level);
+
+// Bytes of the RGBA8 chain of levelCount levels.
+size_t getMipChainBytes(int width, int height, int levelCount);
+
+// Append every level below the image's last one, each the 2x2 box filtered
+// average of the one above. An odd size drops its last row or column, and a
+// side of 1 is reused for both of a pair. With parallel set, rows are split
+// over the job threads, so only pass it from thread 0 after initJobSystem().
+void generateMipmaps(DecodedImage& image, bool parallel);
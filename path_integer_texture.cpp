@@ -0,0 +1,145 @@
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "render_path.h"
+#include "render_thread.h"
+#include "screen.h"
+#include "testbed.h"
+
+static Shader shader;
+
+static GLuint textureId = 0;
+
+static const char* vertexShaderCode = R"V0G0N(
+#version 330 core
+
+//Transformation Matrices
+uniform mat4 projectionMatrix;
+uniform mat4 modelViewMatrix;
+
+in vec3 vertexPos3D;
+
+void main()
+{
+    gl_Position = projectionMatrix * modelViewMatrix * vec4(vertexPos3D.x, vertexPos3D.y, vertexPos3D.z, 1.0);
+}
+)V0G0N";
+
+
+static const char* fragmentShaderCode = R"V0G0N(
+#version 330 core
+
+out vec4 fragColor;
+
+uniform isampler2DRect textureUnit;
+
+in vec4 gl_FragCoord;
+
+void main()
+{
+    // Coordinates of the red pixel.
+    vec2 texCoords = vec2(0, 0);
+
+    vec4 textureSample = texture(textureUnit, texCoords);
+
+    fragColor = textureSample;
+
+    if (textureSample.r == 2147483584 && textureSample.r == 2147483647)
+    {
+        vec4 blue = vec4(0.0, 0.0, 1.0, 1.0);
+
+            // Mix with blue to provide visual output that the case was hit.
+        fragColor = mix(fragColor, blue, 0.5);
+    }
+}
+)V0G0N";
+
+static bool createTexture()
+{
+    GLint glintMax = std::numeric_limits<GLint>::max();
+
+    // 3x1 texture with a red, green, and blue pixel.
+    GLint buffer[12] = {
+        glintMax, 0,        0,        glintMax, // Red
+        0,        glintMax, 0,        glintMax, // Green
+        0,        0,        glintMax, glintMax  // Blue
+    };
+
+    bool texLoaded = loadBufferIntoTexture(buffer, 12, 3, 1, textureId);
+
+    return texLoaded;
+}
+
+static bool init()
+{
+    if (initShader(shader, vertexShaderCode, fragmentShaderCode) == false)
+    {
+        return false;
+    }
+
+    if (createTexture() == false)
+    {
+        std::cout << "Texture Creation Failed" << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+static void buildScene()
+{
+    clearQuads(shader);
+
+    if (benchmarkScene != NULL)
+    {
+        addScene(shader, *benchmarkScene);
+
+        benchmarkSceneShader = &shader;
+
+        return;
+    }
+
+    addQuad(shader, 0, 0, 256, 256, 0, false);
+}
+
+static void renderFrame()
+{
+    if (getQuadCount(shader) > 0)
+    {
+        recordBeginProfileScope("screen pass");
+
+        recordBindFramebuffer(screenFrameBufferId);
+
+        // Init the scene.
+        recordClear(0.0f, 0.0f, 0.0f, 0.0f, GL_COLOR_BUFFER_BIT);
+
+        recordUseProgram(shader.programId);
+
+        recordUpdateQuads(shader);
+
+        recordBindTexture(GL_TEXTURE_RECTANGLE, textureId);
+
+        recordBindVertexArray(shader.texturedQuadVao);
+
+        recordDrawQuads(shader);
+
+        recordBindVertexArray(0);
+
+        recordEndProfileScope();
+    }
+}
+
+static void shutdown()
+{
+    freeShader(shader);
+
+    glDeleteTextures(1, &textureId);
+
+    textureId = 0;
+}
+
+RenderPath integerTexturePath = { "integer-texture", init, buildScene, renderFrame, shutdown };
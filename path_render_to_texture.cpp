@@ -0,0 +1,173 @@
+#include <iostream>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "render_path.h"
+#include "render_thread.h"
+#include "screen.h"
+#include "testbed.h"
+
+static Shader shader;
+
+static GLuint frameBufferId = 0;
+static GLuint renderTextureId = 0;
+
+static const char* vertexShaderCode = R"V0G0N(
+#version 330 core
+
+//Transformation Matrices
+uniform mat4 projectionMatrix;
+uniform mat4 modelViewMatrix;
+
+in vec3 vertexPos3D;
+
+in vec4 color_in;
+
+out VS_OUT
+{
+    vec4 color;
+} vs_out;
+
+void main()
+{
+
+    vs_out.color = color_in;
+
+    gl_Position = projectionMatrix * modelViewMatrix * vec4(vertexPos3D.x, vertexPos3D.y, vertexPos3D.z, 1.0);
+}
+)V0G0N";
+
+
+static const char* fragmentShaderCode = R"V0G0N(
+#version 330 core
+
+layout(location = 0) out vec4 fragColor;
+
+in vec4 gl_FragCoord;
+
+in VS_OUT
+{
+    vec4 color;
+} fs_in;
+
+
+void main()
+{
+    fragColor = fs_in.color;
+}
+)V0G0N";
+
+static bool init()
+{
+    if (initShader(shader, vertexShaderCode, fragmentShaderCode) == false)
+    {
+        return false;
+    }
+
+    return initFbo(frameBufferId, renderTextureId);
+}
+
+static void buildScene()
+{
+    clearQuads(shader);
+
+    if (benchmarkScene != NULL)
+    {
+        addScene(shader, *benchmarkScene);
+
+        benchmarkSceneShader = &shader;
+
+        return;
+    }
+
+    // Reset the group color.
+    resetGroupColor(ColorRgba{ 0.0f, 0.0f, 1.0f, 1.0f });
+
+    addQuad(shader, 0, 0, 1270, 710, 0, false);
+
+    //addSquareQuad(shader, -100,  100,   0, 2, false );
+    //addSquareQuad(shader,    0,    0,   0, 3, false );
+    //addSquareQuad(shader,  -48,  -48, -12, 3, true  );
+    //addSquareQuad(shader, -148, -124,  45, 3, false );
+    //addSquareQuad(shader,   64,  -32, -60, 2, true  );
+    //addSquareQuad(shader,    0,    0,  45, 1, true  );
+    //addSquareQuad(shader,  100,  100,  30, 3, true  );
+    //addSquareQuad(shader,  130,  200,  60, 2, false );
+    //addSquareQuad(shader,  200,  200,  16, 1, false );
+}
+
+static void renderFrame()
+{
+    if (getQuadCount(shader) > 0)
+    {
+
+        recordBeginProfileScope("texture pass");
+
+        recordBindFramebuffer(frameBufferId); // Render to texture
+
+        // Init the scene.
+        recordClear(1.0f, 0.8f, 0.0f, 1.0f, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        recordEnable(GL_DEPTH_TEST);
+
+        //glViewport(0, 0, screenWidth, screenHeight); already set
+
+        recordUseProgram(shader.programId);
+
+        recordUpdateQuads(shader);
+
+        //glActiveTexture(GL_TEXTURE0);
+
+        //glBindTexture(GL_TEXTURE_2D, renderTextureId);
+
+        recordBindVertexArray(shader.texturedQuadVao);
+
+        recordDrawQuads(shader);
+
+        recordEndProfileScope();
+
+        recordBeginProfileScope("screen pass");
+
+        recordBindFramebuffer(screenFrameBufferId); // Render to screen
+
+        // Init the scene.
+        recordClear(1.0f, 0.8f, 0.0f, 1.0f, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        recordEnable(GL_DEPTH_TEST);
+
+        //glViewport(0, 0, screenWidth, screenHeight); already set
+
+        recordUseProgram(shader.programId);
+
+        recordUpdateQuads(shader);
+
+        //glActiveTexture(GL_TEXTURE0);
+
+        //glBindTexture(GL_TEXTURE_2D, renderTextureId);
+
+        recordBindVertexArray(shader.texturedQuadVao);
+
+        recordDrawQuads(shader);
+
+
+        recordBindVertexArray(0);
+
+        recordDisable(GL_DEPTH_TEST);
+
+        recordEndProfileScope();
+    }
+}
+
+static void shutdown()
+{
+    freeShader(shader);
+
+    glDeleteFramebuffers(1, &frameBufferId);
+    glDeleteTextures(1, &renderTextureId);
+
+    frameBufferId = 0;
+    renderTextureId = 0;
+}
+
+RenderPath renderToTexturePath = { "render-to-texture", init, buildScene, renderFrame, shutdown };
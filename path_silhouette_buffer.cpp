@@ -0,0 +1,210 @@
+#include <iostream>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "render_path.h"
+#include "render_thread.h"
+#include "screen.h"
+#include "testbed.h"
+#include "texture_cache.h"
+
+static Shader shader;
+
+static TextureHandle texture = invalidTextureHandle;
+
+static GLuint frameBufferId = 0;
+static GLuint silhouetteTextureId = 0;
+
+static const char* vertexShaderCode = R"V0G0N(
+#version 330 core
+
+//Transformation Matrices
+uniform mat4 projectionMatrix;
+uniform mat4 modelViewMatrix;
+
+in vec3 vertexPos3D;
+
+in vec2 tex_coords_in;
+in vec4 color_in;
+
+out VS_OUT
+{
+    vec2 tex_coords;
+    vec4 color;
+} vs_out;
+
+void main()
+{
+
+    vs_out.tex_coords = tex_coords_in;
+    vs_out.color = color_in;
+
+    gl_Position = projectionMatrix * modelViewMatrix * vec4(vertexPos3D.x, vertexPos3D.y, vertexPos3D.z, 1.0);
+}
+)V0G0N";
+
+
+static const char* fragmentShaderCode = R"V0G0N(
+#version 330 core
+
+out vec4 fragColor;
+
+uniform sampler2D textureUnit;
+
+in vec4 gl_FragCoord;
+
+in VS_OUT
+{
+    vec2 tex_coords;
+    vec4 color;
+} fs_in;
+
+
+bool isOutline(vec4 textureSample)
+{
+    vec2 texelSize = vec2(1.0f / 50.0f, 1.0f / 50.0f);
+
+    // Get the neighboring texel values.
+    vec4 pixelUp    = texture(textureUnit, fs_in.tex_coords - vec2(0, texelSize.y));
+
+    vec4 pixelDown  = texture(textureUnit, fs_in.tex_coords + vec2(0, texelSize.y));
+
+    vec4 pixelLeft  = texture(textureUnit, fs_in.tex_coords - vec2(texelSize.x, 0));
+
+    vec4 pixelRight = texture(textureUnit, fs_in.tex_coords + vec2(texelSize.x, 0));
+
+    // If this pixel is transparent, and any neighboring pixels are not, it is an edge pixel.
+    if (textureSample.a == 0 && (pixelUp.a > 0 || pixelDown.a > 0 || pixelLeft.a > 0 || pixelRight.a > 0))
+    {
+        return true;
+    }
+
+    return false;
+}
+
+void main()
+{
+    vec4 textureSample = texture(textureUnit, fs_in.tex_coords);
+
+    // If this pixel is transparent, and any neighboring pixels are not, it is an edge pixel.
+    bool useOutline = false;
+
+    if (isOutline(textureSample) && useOutline)
+    {
+        //// If a fragment for this group already exists in the buffer, skip the outline.
+        //bool discard = false;
+
+        //if (discard == false)
+        //{
+            fragColor.rgba = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        //}
+    }
+    else
+    {
+        fragColor = textureSample;
+
+        if (fs_in.color.a > 0.0 && fragColor.a > 0.0f)
+        {
+            fragColor = fs_in.color;
+        }
+    }
+
+}
+)V0G0N";
+
+static bool createTexture()
+{
+    texture = acquireTexture("debug_texture.png");
+
+    return texture != invalidTextureHandle;
+}
+
+static bool init()
+{
+    if (initShader(shader, vertexShaderCode, fragmentShaderCode) == false)
+    {
+        return false;
+    }
+
+    if (initFbo(frameBufferId, silhouetteTextureId) == false)
+    {
+        return false;
+    }
+
+    if (createTexture() == false)
+    {
+        std::cout << "Texture Creation Failed" << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+static void buildScene()
+{
+    clearQuads(shader);
+
+    if (benchmarkScene != NULL)
+    {
+        addScene(shader, *benchmarkScene);
+
+        benchmarkSceneShader = &shader;
+
+        return;
+    }
+
+    // Reset the color group counter
+    resetGroupColor(ColorRgba{ 1.0f, 0.0f, 0.0f, 1.0f });
+
+    addSquareQuad(shader, 0, 0, 0, 3, true);
+    addSquareQuad(shader, 48, 48, -12, 3, true);
+    addSquareQuad(shader, -48, -48, 45, 3, false);
+    addSquareQuad(shader, 64, -32, -60, 2, true);
+}
+
+static void renderFrame()
+{
+    if (getQuadCount(shader) > 0)
+    {
+        recordBeginProfileScope("silhouette pass");
+
+        recordBindFramebuffer(frameBufferId);
+        recordViewport(0, 0, screenWidth, screenHeight);
+
+        // Init the scene.
+        recordClear(0.0f, 0.0f, 0.0f, 0.0f, GL_COLOR_BUFFER_BIT);
+
+        recordUseProgram(shader.programId);
+
+        recordUpdateQuads(shader);
+
+        recordBindTexture(GL_TEXTURE_2D, getTextureId(texture));
+
+        recordBindVertexArray(shader.texturedQuadVao);
+
+        recordDrawQuads(shader);
+
+        recordBindVertexArray(0);
+
+        recordEndProfileScope();
+    }
+}
+
+static void shutdown()
+{
+    freeShader(shader);
+
+    // Stays cached for the next run of the path, unless the budget needs it.
+    releaseTexture(texture);
+
+    glDeleteFramebuffers(1, &frameBufferId);
+    glDeleteTextures(1, &silhouetteTextureId);
+
+    texture = invalidTextureHandle;
+    frameBufferId = 0;
+    silhouetteTextureId = 0;
+}
+
+RenderPath silhouetteBufferPath = { "silhouette", init, buildScene, renderFrame, shutdown };
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "render_path.h"
+#include "render_thread.h"
+#include "screen.h"
+#include "testbed.h"
+
+static Shader shader;
+
+static const char* vertexShaderCode = R"V0G0N(
+#version 330 core
+
+//Transformation Matrices
+uniform mat4 projectionMatrix;
+uniform mat4 modelViewMatrix;
+
+in vec3 vertexPos3D;
+
+in vec4 color_in;
+
+out VS_OUT
+{
+    vec4 color;
+} vs_out;
+
+void main()
+{
+
+    vs_out.color = color_in;
+
+    gl_Position = projectionMatrix * modelViewMatrix * vec4(vertexPos3D.x, vertexPos3D.y, vertexPos3D.z, 1.0);
+}
+)V0G0N";
+
+
+static const char* fragmentShaderCode = R"V0G0N(
+#version 330 core
+
+layout(location = 0) out vec4 fragColor;
+
+in vec4 gl_FragCoord;
+
+in VS_OUT
+{
+    vec4 color;
+} fs_in;
+
+
+void main()
+{
+    fragColor = fs_in.color;
+}
+)V0G0N";
+
+static bool init()
+{
+    return initShader(shader, vertexShaderCode, fragmentShaderCode);
+}
+
+static void buildScene()
+{
+    clearQuads(shader);
+
+    if (benchmarkScene != NULL)
+    {
+        addScene(shader, *benchmarkScene);
+
+        benchmarkSceneShader = &shader;
+
+        return;
+    }
+
+    // Reset the group color.
+    resetGroupColor(ColorRgba{ 1.0f, 0.0f, 0.0f, 1.0f });
+
+    addQuad(shader, 0, 0, 256, 256, 0, false);
+}
+
+static void renderFrame()
+{
+    if (getQuadCount(shader) > 0)
+    {
+        recordBeginProfileScope("screen pass");
+
+        recordBindFramebuffer(screenFrameBufferId); // Render to screen
+
+        // Init the scene.
+        recordClear(0.2f, 0.2f, 0.2f, 1.0f, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        recordEnable(GL_DEPTH_TEST);
+
+        //glViewport(0, 0, screenWidth, screenHeight); already set
+
+        recordUseProgram(shader.programId);
+
+        recordUpdateQuads(shader);
+
+        recordBindVertexArray(shader.texturedQuadVao);
+
+        recordDrawQuads(shader);
+
+
+        recordBindVertexArray(0);
+
+        recordDisable(GL_DEPTH_TEST);
+
+        recordEndProfileScope();
+    }
+}
+
+static void shutdown()
+{
+    freeShader(shader);
+}
+
+RenderPath singleQuadPath = { "single-quad", init, buildScene, renderFrame, shutdown };
@@ -0,0 +1,712 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "profiler.h"
+#include "testbed.h"
+
+bool            profilerEnabled = false;
+
+// One scope entered during a frame. The name must be a string literal, it is
+// only read once the frame's queries resolve.
+struct ProfileRecord
+{
+    const char*                             name;
+    int                                     depth;
+    std::chrono::steady_clock::time_point   cpuStart;
+    std::chrono::steady_clock::time_point   cpuEnd;
+
+    // Index of the begin timestamp query, the end is the next one. -1 without timer queries.
+    int                                     query;
+};
+
+struct ProfileFrame
+{
+    bool                                    pending;
+    std::vector<ProfileRecord>              records;
+    std::vector<GLuint>                     queries;
+    int                                     queriesUsed;
+    // GL_TIMESTAMP queries at the start and end of the frame.
+    GLuint                                  frameQueries[2];
+    uint64_t                                frameNumber;
+    std::chrono::steady_clock::time_point   cpuStart;
+    std::chrono::steady_clock::time_point   cpuEnd;
+};
+
+// Per frame samples of one scope, in a ring of profilerHistoryFrames.
+struct ScopeHistory
+{
+    std::string             name;
+    int                     depth;
+    uint64_t                frames;
+    uint64_t                calls;
+    std::vector<double>     cpuMs;
+    std::vector<double>     gpuMs;
+};
+
+// One complete ("X") event of the Chrome trace, in microseconds since the trace started.
+struct TraceEvent
+{
+    const char*     name;
+    int             track;
+    uint64_t        frame;
+    double          start;
+    double          duration;
+};
+
+const int traceCpuTrack = 1;
+const int traceGpuTrack = 2;
+
+// Sum of a scope's calls within one frame.
+struct ScopeTotal
+{
+    const char*     name;
+    int             depth;
+    int             calls;
+    double          cpuMs;
+    double          gpuMs;
+};
+
+static ProfileFrame                 profileFrames[profilerFrameLatency];
+static int                          currentFrame = 0;
+static bool                         frameOpen = false;
+static std::vector<int>             openScopes;
+static bool                         profilerInitialized = false;
+static bool                         gpuTimersAvailable = false;
+static uint64_t                     droppedGpuFrames = 0;
+static std::vector<ScopeHistory>    scopeHistories;
+static std::vector<ScopeTotal>      scopeTotals;
+static uint64_t                     frameNumber = 0;
+
+static bool                                     tracing = false;
+static std::string                              traceFilename;
+static std::vector<TraceEvent>                  traceEvents;
+static std::chrono::steady_clock::time_point    traceCpuStart;
+static GLint64                                  traceGpuStart = 0;
+
+static double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static double queryMilliseconds(GLuint startQuery, GLuint endQuery)
+{
+    GLuint64 start = 0;
+    GLuint64 end = 0;
+
+    glGetQueryObjectui64v(startQuery, GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(endQuery, GL_QUERY_RESULT, &end);
+
+    return (end - start) / 1000000.0;
+}
+
+static bool queryReady(GLuint query)
+{
+    GLint available = GL_FALSE;
+
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    return available == GL_TRUE;
+}
+
+static bool frameQueriesReady(ProfileFrame& frame)
+{
+    // The frame's end timestamp comes after every other query in the frame.
+    return queryReady(frame.frameQueries[1]);
+}
+
+static double traceCpuMicroseconds(std::chrono::steady_clock::time_point time)
+{
+    return std::chrono::duration<double, std::micro>(time - traceCpuStart).count();
+}
+
+static double traceGpuMicroseconds(GLuint query)
+{
+    GLuint64 time = 0;
+
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &time);
+
+    return ((GLint64)time - traceGpuStart) / 1000.0;
+}
+
+static void addTraceEvent(const char* name, int track, uint64_t frame, double start, double end)
+{
+    TraceEvent event = { name, track, frame, start, end - start };
+
+    traceEvents.push_back(event);
+}
+
+static void traceFrame(ProfileFrame& frame, bool gpuReady)
+{
+    addTraceEvent("frame", traceCpuTrack, frame.frameNumber, traceCpuMicroseconds(frame.cpuStart), traceCpuMicroseconds(frame.cpuEnd));
+
+    if (gpuReady == true)
+    {
+        addTraceEvent("frame", traceGpuTrack, frame.frameNumber, traceGpuMicroseconds(frame.frameQueries[0]), traceGpuMicroseconds(frame.frameQueries[1]));
+    }
+
+    for (size_t i = 0; i < frame.records.size(); i++)
+    {
+        ProfileRecord& record = frame.records[i];
+
+        addTraceEvent(record.name, traceCpuTrack, frame.frameNumber, traceCpuMicroseconds(record.cpuStart), traceCpuMicroseconds(record.cpuEnd));
+
+        if (gpuReady == true && record.query >= 0)
+        {
+            addTraceEvent(record.name, traceGpuTrack, frame.frameNumber, traceGpuMicroseconds(frame.queries[record.query]), traceGpuMicroseconds(frame.queries[record.query + 1]));
+        }
+    }
+}
+
+static void addScopeTotal(const char* name, int depth, double cpuMs, double gpuMs)
+{
+    for (size_t i = 0; i < scopeTotals.size(); i++)
+    {
+        if (strcmp(scopeTotals[i].name, name) == 0)
+        {
+            scopeTotals[i].calls++;
+            scopeTotals[i].cpuMs += cpuMs;
+
+            if (gpuMs >= 0.0)
+            {
+                scopeTotals[i].gpuMs = std::max(0.0, scopeTotals[i].gpuMs) + gpuMs;
+            }
+
+            return;
+        }
+    }
+
+    ScopeTotal total = { name, depth, 1, cpuMs, gpuMs };
+
+    scopeTotals.push_back(total);
+}
+
+static void addSample(std::vector<double>& samples, uint64_t frame, double value)
+{
+    if (samples.size() < profilerHistoryFrames)
+    {
+        samples.push_back(value);
+    }
+    else
+    {
+        samples[frame % profilerHistoryFrames] = value;
+    }
+}
+
+// Fold a finished frame into the scope histories. Without GPU results only the CPU times count.
+static void resolveFrame(ProfileFrame& frame, bool gpuReady)
+{
+    scopeTotals.clear();
+
+    double frameGpuMs = -1.0;
+
+    if (gpuReady == true)
+    {
+        frameGpuMs = queryMilliseconds(frame.frameQueries[0], frame.frameQueries[1]);
+    }
+
+    addScopeTotal("frame", 0, millisecondsBetween(frame.cpuStart, frame.cpuEnd), frameGpuMs);
+
+    for (size_t i = 0; i < frame.records.size(); i++)
+    {
+        ProfileRecord& record = frame.records[i];
+
+        double gpuMs = -1.0;
+
+        if (gpuReady == true && record.query >= 0)
+        {
+            gpuMs = queryMilliseconds(frame.queries[record.query], frame.queries[record.query + 1]);
+        }
+
+        addScopeTotal(record.name, record.depth + 1, millisecondsBetween(record.cpuStart, record.cpuEnd), gpuMs);
+    }
+
+    for (size_t i = 0; i < scopeTotals.size(); i++)
+    {
+        ScopeTotal& total = scopeTotals[i];
+
+        ScopeHistory* history = NULL;
+
+        for (size_t h = 0; h < scopeHistories.size(); h++)
+        {
+            if (scopeHistories[h].name == total.name)
+            {
+                history = &scopeHistories[h];
+
+                break;
+            }
+        }
+
+        if (history == NULL)
+        {
+            scopeHistories.push_back(ScopeHistory());
+
+            history = &scopeHistories.back();
+
+            history->name = total.name;
+            history->depth = total.depth;
+            history->frames = 0;
+            history->calls = 0;
+
+            // Sized once, so steady-state frames don't reallocate while the ring fills.
+            history->cpuMs.reserve(profilerHistoryFrames);
+            history->gpuMs.reserve(profilerHistoryFrames);
+        }
+
+        addSample(history->cpuMs, history->frames, total.cpuMs);
+        addSample(history->gpuMs, history->frames, total.gpuMs);
+
+        history->frames++;
+        history->calls += total.calls;
+    }
+
+    if (tracing == true)
+    {
+        traceFrame(frame, gpuReady);
+    }
+
+    frame.pending = false;
+}
+
+// Wait for every frame still in flight and fold it in, oldest first.
+static void flushProfilerFrames()
+{
+    bool anyPending = false;
+
+    for (int i = 0; i < profilerFrameLatency; i++)
+    {
+        anyPending |= profileFrames[i].pending;
+    }
+
+    if (anyPending == false)
+    {
+        return;
+    }
+
+    glFinish();
+
+    for (int i = 1; i <= profilerFrameLatency; i++)
+    {
+        ProfileFrame& frame = profileFrames[(currentFrame + i) % profilerFrameLatency];
+
+        if (frame.pending == true)
+        {
+            resolveFrame(frame, gpuTimersAvailable);
+        }
+    }
+}
+
+bool initProfiler()
+{
+    // Timer queries are core since 3.3.
+    gpuTimersAvailable = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+
+    if (gpuTimersAvailable == false)
+    {
+        std::cout << "Timer queries not supported, the profiler only measures CPU time" << std::endl;
+    }
+
+    for (int i = 0; i < profilerFrameLatency; i++)
+    {
+        ProfileFrame& frame = profileFrames[i];
+
+        frame.pending = false;
+        frame.queriesUsed = 0;
+        frame.frameQueries[0] = 0;
+        frame.frameQueries[1] = 0;
+
+        if (gpuTimersAvailable == true)
+        {
+            glGenQueries(2, frame.frameQueries);
+        }
+    }
+
+    RETURN_IF_GL_ERROR("initProfiler");
+
+    currentFrame = 0;
+    frameOpen = false;
+    profilerInitialized = true;
+
+    return true;
+}
+
+void shutdownProfiler()
+{
+    if (profilerInitialized == false)
+    {
+        return;
+    }
+
+    if (tracing == true)
+    {
+        endProfilerTrace();
+    }
+
+    for (int i = 0; i < profilerFrameLatency; i++)
+    {
+        ProfileFrame& frame = profileFrames[i];
+
+        if (frame.queries.empty() == false)
+        {
+            glDeleteQueries(frame.queries.size(), &frame.queries[0]);
+        }
+
+        if (frame.frameQueries[0] != 0)
+        {
+            glDeleteQueries(2, frame.frameQueries);
+        }
+
+        frame.queries.clear();
+        frame.records.clear();
+        frame.frameQueries[0] = 0;
+        frame.frameQueries[1] = 0;
+        frame.pending = false;
+    }
+
+    profilerInitialized = false;
+    frameOpen = false;
+}
+
+void resetProfiler()
+{
+    // Results still in flight belong to whatever ran before. Finish them so
+    // the trace keeps them, then start the statistics over.
+    if (profilerInitialized == true)
+    {
+        flushProfilerFrames();
+    }
+
+    scopeHistories.clear();
+    droppedGpuFrames = 0;
+}
+
+void beginProfilerFrame()
+{
+    if (profilerEnabled == false || profilerInitialized == false)
+    {
+        return;
+    }
+
+    currentFrame = (currentFrame + 1) % profilerFrameLatency;
+
+    ProfileFrame& frame = profileFrames[currentFrame];
+
+    // Still not finished after a full ring of frames. Keep its CPU times rather than wait on the GPU.
+    if (frame.pending == true)
+    {
+        resolveFrame(frame, false);
+
+        droppedGpuFrames++;
+    }
+
+    frame.records.clear();
+    frame.queriesUsed = 0;
+    frame.frameNumber = frameNumber++;
+
+    openScopes.clear();
+
+    frameOpen = true;
+
+    frame.cpuStart = std::chrono::steady_clock::now();
+
+    if (gpuTimersAvailable == true)
+    {
+        glQueryCounter(frame.frameQueries[0], GL_TIMESTAMP);
+    }
+}
+
+void endProfilerFrame()
+{
+    if (frameOpen == false)
+    {
+        return;
+    }
+
+    // Close anything left open, so a missing end doesn't corrupt later frames.
+    while (openScopes.empty() == false)
+    {
+        endProfileScope();
+    }
+
+    ProfileFrame& frame = profileFrames[currentFrame];
+
+    if (gpuTimersAvailable == true)
+    {
+        glQueryCounter(frame.frameQueries[1], GL_TIMESTAMP);
+    }
+
+    frame.cpuEnd = std::chrono::steady_clock::now();
+    frame.pending = true;
+
+    frameOpen = false;
+
+    if (gpuTimersAvailable == false)
+    {
+        resolveFrame(frame, false);
+
+        return;
+    }
+
+    // Oldest first. Frames finish in order, so stop at the first one that isn't ready.
+    for (int i = 1; i < profilerFrameLatency; i++)
+    {
+        ProfileFrame& olderFrame = profileFrames[(currentFrame + i) % profilerFrameLatency];
+
+        if (olderFrame.pending == false)
+        {
+            continue;
+        }
+
+        if (frameQueriesReady(olderFrame) == false)
+        {
+            break;
+        }
+
+        resolveFrame(olderFrame, true);
+    }
+}
+
+void beginProfileScope(const char* name)
+{
+    if (frameOpen == false)
+    {
+        return;
+    }
+
+    ProfileFrame& frame = profileFrames[currentFrame];
+
+    ProfileRecord record;
+
+    record.name = name;
+    record.depth = openScopes.size();
+    record.query = -1;
+
+    if (gpuTimersAvailable == true)
+    {
+        if (frame.queriesUsed + 2 > (int)frame.queries.size())
+        {
+            size_t oldSize = frame.queries.size();
+
+            frame.queries.resize(std::max<size_t>(32, oldSize * 2));
+
+            glGenQueries(frame.queries.size() - oldSize, &frame.queries[oldSize]);
+        }
+
+        record.query = frame.queriesUsed;
+
+        frame.queriesUsed += 2;
+
+        glQueryCounter(frame.queries[record.query], GL_TIMESTAMP);
+    }
+
+    record.cpuStart = std::chrono::steady_clock::now();
+
+    openScopes.push_back(frame.records.size());
+
+    frame.records.push_back(record);
+}
+
+void endProfileScope()
+{
+    if (frameOpen == false || openScopes.empty() == true)
+    {
+        return;
+    }
+
+    ProfileFrame& frame = profileFrames[currentFrame];
+
+    ProfileRecord& record = frame.records[openScopes.back()];
+
+    record.cpuEnd = std::chrono::steady_clock::now();
+
+    if (record.query >= 0)
+    {
+        glQueryCounter(frame.queries[record.query + 1], GL_TIMESTAMP);
+    }
+
+    openScopes.pop_back();
+}
+
+// Nearest rank percentiles of the samples, ignoring negative (missing) ones.
+static void summarize(const std::vector<double>& samples, double& mean, double& p50, double& p95, double& p99)
+{
+    std::vector<double> sorted;
+
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        if (samples[i] >= 0.0)
+        {
+            sorted.push_back(samples[i]);
+        }
+    }
+
+    if (sorted.empty() == true)
+    {
+        mean = p50 = p95 = p99 = -1.0;
+
+        return;
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        total += sorted[i];
+    }
+
+    mean = total / sorted.size();
+    p50 = sorted[(size_t)(0.50 * (sorted.size() - 1) + 0.5)];
+    p95 = sorted[(size_t)(0.95 * (sorted.size() - 1) + 0.5)];
+    p99 = sorted[(size_t)(0.99 * (sorted.size() - 1) + 0.5)];
+}
+
+void getProfileStats(std::vector<ProfileStats>& stats)
+{
+    stats.clear();
+
+    for (size_t i = 0; i < scopeHistories.size(); i++)
+    {
+        ScopeHistory& history = scopeHistories[i];
+
+        ProfileStats scopeStats;
+
+        scopeStats.name = history.name;
+        scopeStats.depth = history.depth;
+        scopeStats.frames = history.frames;
+        scopeStats.callsPerFrame = history.frames > 0 ? (double)history.calls / history.frames : 0.0;
+
+        summarize(history.cpuMs, scopeStats.cpuMean, scopeStats.cpuP50, scopeStats.cpuP95, scopeStats.cpuP99);
+        summarize(history.gpuMs, scopeStats.gpuMean, scopeStats.gpuP50, scopeStats.gpuP95, scopeStats.gpuP99);
+
+        stats.push_back(scopeStats);
+    }
+}
+
+void printProfileReport()
+{
+    std::vector<ProfileStats> stats;
+
+    getProfileStats(stats);
+
+    std::cout << std::left << std::setw(28) << "scope" << std::right
+        << std::setw(8) << "calls"
+        << std::setw(10) << "cpu avg" << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99"
+        << std::setw(10) << "gpu avg" << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99"
+        << std::endl;
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        ProfileStats& scope = stats[i];
+
+        std::cout << std::left << std::setw(28) << (std::string(scope.depth * 2, ' ') + scope.name) << std::right
+            << std::setw(8) << std::setprecision(1) << scope.callsPerFrame << std::setprecision(3)
+            << std::setw(10) << scope.cpuMean << std::setw(10) << scope.cpuP50 << std::setw(10) << scope.cpuP95 << std::setw(10) << scope.cpuP99;
+
+        if (scope.gpuMean >= 0.0)
+        {
+            std::cout << std::setw(10) << scope.gpuMean << std::setw(10) << scope.gpuP50 << std::setw(10) << scope.gpuP95 << std::setw(10) << scope.gpuP99;
+        }
+
+        std::cout << std::endl;
+    }
+
+    std::cout << std::defaultfloat << std::setprecision(6);
+
+    if (droppedGpuFrames > 0)
+    {
+        std::cout << droppedGpuFrames << " frames had no GPU times, their queries were still in flight" << std::endl;
+    }
+}
+
+bool profilerTracing()
+{
+    return tracing;
+}
+
+bool beginProfilerTrace(std::string filename)
+{
+    if (profilerInitialized == false)
+    {
+        return false;
+    }
+
+    // Traces are built from the profiler's scopes.
+    profilerEnabled = true;
+
+    tracing = true;
+    traceFilename = filename;
+    traceEvents.clear();
+
+    // Pair a GPU timestamp with a CPU time so both tracks share one time line.
+    // GL_TIMESTAMP reads when the GL gets the query, so the GPU track may lead
+    // the CPU one by the driver's queueing latency.
+    if (gpuTimersAvailable == true)
+    {
+        glFinish();
+
+        glGetInteger64v(GL_TIMESTAMP, &traceGpuStart);
+    }
+
+    traceCpuStart = std::chrono::steady_clock::now();
+
+    return true;
+}
+
+bool endProfilerTrace()
+{
+    if (tracing == false)
+    {
+        return false;
+    }
+
+    flushProfilerFrames();
+
+    tracing = false;
+
+    std::ofstream file(traceFilename.c_str());
+
+    if (file.is_open() == false)
+    {
+        std::cout << "Failed to open trace file " << traceFilename << std::endl;
+
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+
+    file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"OpenGLTestbed\"}}," << std::endl;
+    file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << traceCpuTrack << ", \"args\": {\"name\": \"CPU\"}}," << std::endl;
+    file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << traceGpuTrack << ", \"args\": {\"name\": \"GPU\"}}";
+
+    file << std::fixed << std::setprecision(3);
+
+    for (size_t i = 0; i < traceEvents.size(); i++)
+    {
+        TraceEvent& event = traceEvents[i];
+
+        file << "," << std::endl;
+        file << "{\"name\": \"" << event.name << "\", \"cat\": \"" << (event.track == traceGpuTrack ? "gpu" : "cpu") << "\", \"ph\": \"X\""
+            << ", \"pid\": 1, \"tid\": " << event.track
+            << ", \"ts\": " << event.start << ", \"dur\": " << event.duration
+            << ", \"args\": {\"frame\": " << event.frame << "}}";
+    }
+
+    file << std::endl << "]}" << std::endl;
+
+    std::cout << "Wrote " << traceEvents.size() << " trace events to " << traceFilename << std::endl;
+
+    traceEvents.clear();
+
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Frames of GPU queries kept in flight. Results are read back this many
+// frames late, by which time the GPU has finished with them, so reading
+// never stalls the pipeline.
+const int profilerFrameLatency = 4;
+
+// Number of frames each scope keeps for its rolling statistics.
+const int profilerHistoryFrames = 240;
+
+// Set to start collecting. Scopes cost nothing beyond a branch while it is false.
+extern bool            profilerEnabled;
+
+// Rolling statistics of one named scope, in milliseconds per frame. A scope
+// entered several times in a frame counts the sum of its calls.
+struct ProfileStats
+{
+    std::string     name;
+    int             depth;
+    uint64_t        frames;
+    double          callsPerFrame;
+    double          cpuMean;
+    double          cpuP50;
+    double          cpuP95;
+    double          cpuP99;
+
+    // Negative when the GL has no timer queries.
+    double          gpuMean;
+    double          gpuP50;
+    double          gpuP95;
+    double          gpuP99;
+};
+
+// Create the query pools. Needs a current GL context.
+bool initProfiler();
+
+void shutdownProfiler();
+
+// Forget all collected statistics, e.g. between render paths.
+void resetProfiler();
+
+void beginProfilerFrame();
+
+// Close the frame and fold in the results of any earlier frame whose queries are ready.
+void endProfilerFrame();
+
+// Scopes nest: each one records CPU time with std::chrono and GPU time with a
+// pair of GL_TIMESTAMP queries, since GL_TIME_ELAPSED queries can't overlap.
+void beginProfileScope(const char* name);
+
+void endProfileScope();
+
+// Statistics for every scope seen since the last reset, parents before children.
+// The whole frame is reported as "frame".
+void getProfileStats(std::vector<ProfileStats>& stats);
+
+void printProfileReport();
+
+// Record every scope as Chrome trace events, on a CPU and a GPU track, until
+// endProfilerTrace() writes them to filename. Enables the profiler.
+bool beginProfilerTrace(std::string filename);
+
+// Write the trace JSON, which chrome://tracing and ui.perfetto.dev open.
+bool endProfilerTrace();
+
+// True while a trace records. Its events grow every frame.
+bool profilerTracing();
+
+struct ProfileScope
+{
+    ProfileScope(const char* name) { beginProfileScope(name); }
+    ~ProfileScope() { endProfileScope(); }
+};
+
+#define PROFILE_SCOPE_NAME2(line) profileScope##line
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_NAME2(line)
+
+// Profile the rest of the enclosing block.
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_NAME(__LINE__)(name)
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "frame_arena.h"
+#include "quad_groups.h"
+#include "testbed.h"
+
+bool            groupedDraws = false;
+
+void addQuadGroupStart(Shader& shader, int quadIndex, bool newGroup)
+{
+    if (shader.groupStarts.empty() == true)
+    {
+        shader.groupStarts.push_back(0);
+    }
+
+    if (newGroup == true)
+    {
+        shader.groupStarts.push_back(quadIndex);
+    }
+}
+
+int getQuadGroupCount(const Shader& shader)
+{
+    return shader.groupStarts.size();
+}
+
+void getQuadGroupRange(const Shader& shader, int group, int& first, int& count)
+{
+    int quadCount = getQuadCount(shader);
+
+    int groupCount = shader.groupStarts.size();
+
+    if (group < 0 || group >= groupCount)
+    {
+        first = 0;
+        count = 0;
+
+        return;
+    }
+
+    int end = (group + 1 < groupCount) ? shader.groupStarts[group + 1] : quadCount;
+
+    first = std::min(shader.groupStarts[group], quadCount);
+    count = std::max(0, std::min(end, quadCount) - first);
+}
+
+void setQuadGroupVisible(Shader& shader, int group, bool visible)
+{
+    if (group < 0)
+    {
+        return;
+    }
+
+    if (group >= (int)shader.groupHidden.size())
+    {
+        if (visible == true)
+        {
+            return;
+        }
+
+        shader.groupHidden.resize(group + 1, 0);
+    }
+
+    shader.groupHidden[group] = visible ? 0 : 1;
+}
+
+bool quadGroupVisible(const Shader& shader, int group)
+{
+    return group >= (int)shader.groupHidden.size() || shader.groupHidden[group] == 0;
+}
+
+void setQuadGroupDrawOrder(Shader& shader, const std::vector<int>& order)
+{
+    shader.groupDrawOrder = order;
+}
+
+void raiseQuadGroup(Shader& shader, int group)
+{
+    std::vector<int>& order = shader.groupDrawOrder;
+
+    order.erase(std::remove(order.begin(), order.end(), group), order.end());
+
+    order.push_back(group);
+}
+
+// Append a group's quads to the last run, or start a new one if they don't follow it.
+static void addDrawRange(std::vector<QuadDrawRange>& ranges, int first, int count)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    if (ranges.empty() == false && ranges.back().first + ranges.back().count == first)
+    {
+        ranges.back().count += count;
+
+        return;
+    }
+
+    ranges.push_back(QuadDrawRange{ first, count });
+}
+
+int collectQuadGroupDrawRanges(Shader& shader, int quadCount)
+{
+    std::vector<QuadDrawRange>& ranges = shader.groupDrawRanges;
+
+    ranges.clear();
+
+    if (quadCount == 0)
+    {
+        return 0;
+    }
+
+    int groupCount = shader.groupStarts.size();
+
+    // Quads added without groups, e.g. only through resizeQuads(), are one group.
+    if (groupCount == 0)
+    {
+        addDrawRange(ranges, 0, quadCount);
+
+        return ranges.size();
+    }
+
+    auto groupEnd = [&](int group)
+    {
+        int end = (group + 1 < groupCount) ? shader.groupStarts[group + 1] : quadCount;
+
+        return std::min(end, quadCount);
+    };
+
+    auto addGroup = [&](int group)
+    {
+        if (quadGroupVisible(shader, group) == true)
+        {
+            int first = std::min(shader.groupStarts[group], quadCount);
+
+            addDrawRange(ranges, first, groupEnd(group) - first);
+        }
+    };
+
+    if (shader.groupDrawOrder.empty() == true)
+    {
+        for (int group = 0; group < groupCount; group++)
+        {
+            addGroup(group);
+        }
+
+        return ranges.size();
+    }
+
+    // The raised groups are left out of the first pass, then drawn over it.
+    uint8_t* raised = frameArenaAllocateArray<uint8_t>(groupCount);
+
+    memset(raised, 0, groupCount);
+
+    for (size_t i = 0; i < shader.groupDrawOrder.size(); i++)
+    {
+        int group = shader.groupDrawOrder[i];
+
+        if (group >= 0 && group < groupCount)
+        {
+            raised[group] = 1;
+        }
+    }
+
+    for (int group = 0; group < groupCount; group++)
+    {
+        if (raised[group] == 0)
+        {
+            addGroup(group);
+        }
+    }
+
+    for (size_t i = 0; i < shader.groupDrawOrder.size(); i++)
+    {
+        int group = shader.groupDrawOrder[i];
+
+        // Listed twice, it is drawn where it was listed first.
+        if (group >= 0 && group < groupCount && raised[group] == 1)
+        {
+            raised[group] = 0;
+
+            addGroup(group);
+        }
+    }
+
+    return ranges.size();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "testbed.h"
+
+// When set, render paths draw their quads group by group from a small buffer
+// of indirect draw commands, so hiding or reordering a group only rewrites
+// those commands, never the vertex data. Set before initShader().
+extern bool            groupedDraws;
+
+// Note that quad quadIndex was just added, starting a group when newGroup is
+// set. Group 0 holds the quads before the first new group, and is empty when
+// the very first quad starts one.
+void addQuadGroupStart(Shader& shader, int quadIndex, bool newGroup);
+
+// Groups added since clearQuads().
+int getQuadGroupCount(const Shader& shader);
+
+// Quads [first, first + count) of group group. Quads created by a QuadStore go
+// to the last group, and compacting its holes away keeps every group's quads.
+void getQuadGroupRange(const Shader& shader, int group, int& first, int& count);
+
+// Hidden groups keep their quads uploaded, their draws are just left out.
+void setQuadGroupVisible(Shader& shader, int group, bool visible);
+
+bool quadGroupVisible(const Shader& shader, int group);
+
+// Draw the listed groups last, in list order, over the others, which go in
+// index order first. An empty list draws every group in index order.
+void setQuadGroupDrawOrder(Shader& shader, const std::vector<int>& order);
+
+// Draw group last, over every other: how a group is highlighted.
+void raiseQuadGroup(Shader& shader, int group);
+
+// Build the runs of quads the visible groups make, in draw order and clipped to
+// quadCount, into shader.groupDrawRanges. Groups next to each other in both
+// order and quads share a run, so with nothing hidden or raised every quad is
+// in one. Returns the number of runs.
+int collectQuadGroupDrawRanges(Shader& shader, int quadCount);
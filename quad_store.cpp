@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "quad_store.h"
+#include "testbed.h"
+
+void markQuadsDirty(Shader& shader, int first, int count)
+{
+    if (shader.retained == false)
+    {
+        return;
+    }
+
+    int end = std::min(first + count, shader.uploadedQuadCount);
+
+    for (int i = first; i < end; i++)
+    {
+        if (shader.quadDirty[i] == 0)
+        {
+            shader.quadDirty[i] = 1;
+
+            shader.dirtyQuads.push_back(i);
+        }
+    }
+}
+
+void clearDirtyQuads(Shader& shader)
+{
+    for (size_t i = 0; i < shader.dirtyQuads.size(); i++)
+    {
+        shader.quadDirty[shader.dirtyQuads[i]] = 0;
+    }
+
+    shader.dirtyQuads.clear();
+}
+
+// Add quads [first, first + count) to the last range, or start a new one if
+// the gap to it is too long.
+static void addDirtyRange(std::vector<QuadRange>& ranges, int first, int count)
+{
+    if (ranges.empty() == false)
+    {
+        QuadRange& last = ranges.back();
+
+        if (first <= last.first + last.count + quadRangeMergeGap)
+        {
+            last.count = std::max(last.count, first + count - last.first);
+
+            return;
+        }
+    }
+
+    ranges.push_back(QuadRange{ first, count, NULL });
+}
+
+int collectDirtyQuadRanges(Shader& shader)
+{
+    shader.dirtyRanges.clear();
+
+    int quadCount = getQuadCount(shader);
+
+    std::sort(shader.dirtyQuads.begin(), shader.dirtyQuads.end());
+
+    for (size_t i = 0; i < shader.dirtyQuads.size(); i++)
+    {
+        int quadIndex = shader.dirtyQuads[i];
+
+        shader.quadDirty[quadIndex] = 0;
+
+        // Dropped off the end since it was marked.
+        if (quadIndex < quadCount)
+        {
+            addDirtyRange(shader.dirtyRanges, quadIndex, 1);
+        }
+    }
+
+    shader.dirtyQuads.clear();
+
+    if (quadCount > shader.uploadedQuadCount)
+    {
+        addDirtyRange(shader.dirtyRanges, shader.uploadedQuadCount, quadCount - shader.uploadedQuadCount);
+    }
+
+    const unsigned char* quadData = static_cast<const unsigned char*>(getQuadData(shader));
+
+    size_t quadBytes = getBytesPerQuad();
+
+    for (size_t i = 0; i < shader.dirtyRanges.size(); i++)
+    {
+        shader.dirtyRanges[i].data = quadData + shader.dirtyRanges[i].first * quadBytes;
+    }
+
+    shader.uploadedQuadCount = quadCount;
+
+    // New flags start clean, and all the old ones were cleared above.
+    shader.quadDirty.resize(std::max<size_t>(shader.quadDirty.size(), quadCount), 0);
+
+    return shader.dirtyRanges.size();
+}
+
+static uint32_t handleSlot(QuadHandle handle)
+{
+    return handle & 0x00FFFFFF;
+}
+
+static uint8_t handleGeneration(QuadHandle handle)
+{
+    return handle >> 24;
+}
+
+static QuadHandle makeQuadHandle(uint32_t slot, uint8_t generation)
+{
+    return ((QuadHandle)generation << 24) | slot;
+}
+
+void initQuadStore(QuadStore& store, Shader& shader)
+{
+    int quadCount = getQuadCount(shader);
+
+    store.shader = &shader;
+
+    store.slotQuads.resize(quadCount);
+    store.quadSlots.resize(quadCount);
+
+    store.slotGenerations.assign(quadCount, 0);
+    store.freeSlots.clear();
+
+    store.deadQuadCount = 0;
+    store.firstDeadQuad = 0;
+
+    for (int i = 0; i < quadCount; i++)
+    {
+        store.slotQuads[i] = i;
+        store.quadSlots[i] = i;
+    }
+}
+
+QuadHandle createQuad(QuadStore& store, float x, float y, float w, float h, float rotationDegrees, ColorRgba color)
+{
+    uint32_t slot;
+
+    if (store.freeSlots.empty() == false)
+    {
+        slot = store.freeSlots.back();
+
+        store.freeSlots.pop_back();
+    }
+    else
+    {
+        slot = store.slotQuads.size();
+
+        // Slot 0xFFFFFF would make invalidQuadHandle at generation 255.
+        if (slot >= 0x00FFFFFF)
+        {
+            return invalidQuadHandle;
+        }
+
+        store.slotQuads.push_back(-1);
+        store.slotGenerations.push_back(0);
+    }
+
+    int quadIndex = getQuadCount(*store.shader);
+
+    resizeQuads(*store.shader, quadIndex + 1);
+
+    writeQuad(*store.shader, quadIndex, x, y, w, h, rotationDegrees, color);
+
+    store.slotQuads[slot] = quadIndex;
+    store.quadSlots.push_back(slot);
+
+    return makeQuadHandle(slot, store.slotGenerations[slot]);
+}
+
+int getQuadIndex(const QuadStore& store, QuadHandle handle)
+{
+    uint32_t slot = handleSlot(handle);
+
+    if (handle == invalidQuadHandle || slot >= store.slotQuads.size() || store.slotGenerations[slot] != handleGeneration(handle))
+    {
+        return -1;
+    }
+
+    return store.slotQuads[slot];
+}
+
+bool quadHandleValid(const QuadStore& store, QuadHandle handle)
+{
+    return getQuadIndex(store, handle) >= 0;
+}
+
+bool updateQuad(QuadStore& store, QuadHandle handle, float x, float y, float w, float h, float rotationDegrees, ColorRgba color)
+{
+    int quadIndex = getQuadIndex(store, handle);
+
+    if (quadIndex < 0)
+    {
+        return false;
+    }
+
+    writeQuad(*store.shader, quadIndex, x, y, w, h, rotationDegrees, color);
+
+    return true;
+}
+
+bool destroyQuad(QuadStore& store, QuadHandle handle)
+{
+    int quadIndex = getQuadIndex(store, handle);
+
+    if (quadIndex < 0)
+    {
+        return false;
+    }
+
+    uint32_t slot = handleSlot(handle);
+
+    // A zero sized quad, so the hole draws nothing until it is compacted.
+    writeQuad(*store.shader, quadIndex, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, ColorRgba{ 0.0f, 0.0f, 0.0f, 0.0f });
+
+    store.quadSlots[quadIndex] = deadQuadSlot;
+
+    if (store.deadQuadCount == 0 || quadIndex < store.firstDeadQuad)
+    {
+        store.firstDeadQuad = quadIndex;
+    }
+
+    store.deadQuadCount++;
+
+    store.slotQuads[slot] = -1;
+    store.slotGenerations[slot]++;
+    store.freeSlots.push_back(slot);
+
+    return true;
+}
+
+void compactQuadStore(QuadStore& store)
+{
+    if (store.deadQuadCount == 0)
+    {
+        return;
+    }
+
+    Shader& shader = *store.shader;
+
+    std::vector<int>& groupStarts = shader.groupStarts;
+
+    int quadCount = store.quadSlots.size();
+
+    // Groups starting before the first hole keep their start.
+    size_t group = std::lower_bound(groupStarts.begin(), groupStarts.end(), store.firstDeadQuad) - groupStarts.begin();
+
+    int write = store.firstDeadQuad;
+
+    for (int read = store.firstDeadQuad; read < quadCount; read++)
+    {
+        // A group now starts where its first quad lands.
+        while (group < groupStarts.size() && groupStarts[group] <= read)
+        {
+            groupStarts[group++] = write;
+        }
+
+        uint32_t slot = store.quadSlots[read];
+
+        if (slot == deadQuadSlot)
+        {
+            continue;
+        }
+
+        if (read != write)
+        {
+            moveQuad(shader, read, write);
+
+            store.quadSlots[write] = slot;
+            store.slotQuads[slot] = write;
+        }
+
+        write++;
+    }
+
+    // Groups left empty at the end.
+    for (; group < groupStarts.size(); group++)
+    {
+        groupStarts[group] = write;
+    }
+
+    store.quadSlots.resize(write);
+
+    resizeQuads(shader, write);
+
+    store.deadQuadCount = 0;
+    store.firstDeadQuad = 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "testbed.h"
+
+// Clean quads in a gap this short between two dirty ranges are sent along,
+// one bigger write being cheaper than two calls.
+const int quadRangeMergeGap = 8;
+
+// Note quads [first, first + count) changed since the last upload. Only
+// retained shaders keep track, and only of quads already uploaded: the ones
+// past them are sent anyway.
+void markQuadsDirty(Shader& shader, int first, int count);
+
+void clearDirtyQuads(Shader& shader);
+
+// Coalesce the dirty quads, and the ones added since the last upload, into
+// sorted ranges in shader.dirtyRanges pointing at the staging vector, and
+// count everything as uploaded. Returns the number of ranges, 0 when nothing
+// changed.
+int collectDirtyQuadRanges(Shader& shader);
+
+// Names a quad of a QuadStore for as long as it lives, however quads move
+// around: a slot index in the low 24 bits, and in the high 8 the slot's
+// generation, which destroying the quad bumps so old handles stop matching.
+typedef uint32_t QuadHandle;
+
+const QuadHandle invalidQuadHandle = 0xFFFFFFFF;
+
+// Slot of a destroyed quad not yet compacted away.
+const uint32_t deadQuadSlot = 0xFFFFFFFF;
+
+// The quads of a retained shader, by handle. Quads keep their order, which is
+// their draw order and decides their group: destroying one leaves a blank hole
+// in its place, and compactQuadStore() later closes every hole at once.
+struct QuadStore
+{
+    Shader*                 shader;
+
+    // Quad index of each slot, -1 for free ones.
+    std::vector<int>        slotQuads;
+
+    // Slot of each quad, deadQuadSlot for holes.
+    std::vector<uint32_t>   quadSlots;
+
+    // Holes, and the first of them when there are any.
+    int                     deadQuadCount;
+    int                     firstDeadQuad;
+
+    std::vector<uint8_t>    slotGenerations;
+    std::vector<uint32_t>   freeSlots;
+};
+
+// Start a store over the shader's quads. Quads already added get handles
+// 0 .. n - 1, in order.
+void initQuadStore(QuadStore& store, Shader& shader);
+
+// Add a w x h quad centered at world point (x, y), after every other quad,
+// so in the last group.
+QuadHandle createQuad(QuadStore& store, float x, float y, float w, float h, float rotationDegrees, ColorRgba color);
+
+// Rewrite a quad. Returns false, changing nothing, for a stale handle.
+bool updateQuad(QuadStore& store, QuadHandle handle, float x, float y, float w, float h, float rotationDegrees, ColorRgba color);
+
+// Blank the quad, so it draws nothing, and free its handle. Its hole is
+// only closed by compactQuadStore().
+bool destroyQuad(QuadStore& store, QuadHandle handle);
+
+// Close the holes destroyed quads left, shifting the quads after the first
+// one down in order and the shader's group starts with them. The quads moved
+// make one dirty range, from the first hole on. Call once a frame, after its
+// destroys and before its upload.
+void compactQuadStore(QuadStore& store);
+
+bool quadHandleValid(const QuadStore& store, QuadHandle handle);
+
+// Quad index the handle's quad is at now, -1 for a stale handle.
+int getQuadIndex(const QuadStore& store, QuadHandle handle);
@@ -0,0 +1,751 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TRANSFORM_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit the instructions of the functions marked for them,
+// so the rest of the file still runs on any CPU. MSVC takes the intrinsics as they are.
+#if defined(TRANSFORM_X86) && defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+#include "quad_transform.h"
+#include "screen.h"
+#include "testbed.h"
+
+TransformKernel transformKernel = TRANSFORM_KERNEL_AUTO;
+
+// Largest error allowed against rotatePoints(), in pixels.
+static const float transformTolerance = 0.01f;
+
+static const float degreesToRadians = 3.14159265358979f / 180.0f;
+
+// Minimax polynomials for sin and cos on [-pi/4, pi/4], from Cephes' sinf and cosf.
+static const float sinCoefficient0 = -1.6666654611e-1f;
+static const float sinCoefficient1 = 8.3321608736e-3f;
+static const float sinCoefficient2 = -1.9515295891e-4f;
+
+static const float cosCoefficient0 = 4.166664568298827e-2f;
+static const float cosCoefficient1 = -1.388731625493765e-3f;
+static const float cosCoefficient2 = 2.443315711809948e-5f;
+
+void QuadTransformBatch::resize(size_t count)
+{
+    x.resize(count);
+    y.resize(count);
+    rotationDegrees.resize(count);
+    scale.resize(count);
+}
+
+// The angle is split into a multiple of 90 degrees, which only swaps and negates
+// sin and cos, and a remainder within 45 degrees for the polynomials. The vector
+// kernels repeat these steps operation for operation, so all give the same bits.
+static void sinCosDegrees(float degrees, float& sinTheta, float& cosTheta)
+{
+    int quadrant = (int)lrintf(degrees * (1.0f / 90.0f));
+
+    float radians = (degrees - (float)quadrant * 90.0f) * degreesToRadians;
+
+    float radians2 = radians * radians;
+
+    float sinValue = (sinCoefficient2 * radians2 + sinCoefficient1) * radians2 + sinCoefficient0;
+    sinValue = sinValue * radians2 * radians;
+    sinValue = sinValue + radians;
+
+    float cosValue = (cosCoefficient2 * radians2 + cosCoefficient1) * radians2 + cosCoefficient0;
+    cosValue = cosValue * radians2 * radians2;
+    cosValue = cosValue - 0.5f * radians2;
+    cosValue = cosValue + 1.0f;
+
+    if (quadrant & 1)
+    {
+        std::swap(sinValue, cosValue);
+    }
+
+    sinTheta = (quadrant & 2) ? -sinValue : sinValue;
+    cosTheta = ((quadrant + 1) & 2) ? -cosValue : cosValue;
+}
+
+static void transformQuadCornersScalar(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, Vertex2* corners)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float sinTheta;
+        float cosTheta;
+
+        sinCosDegrees(rotationDegrees[i], sinTheta, cosTheta);
+
+        float scaledHalfWidth = halfWidth * scale[i];
+        float scaledHalfHeight = halfHeight * scale[i];
+
+        float widthCos = scaledHalfWidth * cosTheta;
+        float widthSin = scaledHalfWidth * sinTheta;
+        float heightCos = scaledHalfHeight * cosTheta;
+        float heightSin = scaledHalfHeight * sinTheta;
+
+        // Rotated offsets of corners 1 and 2. Corners 3 and 0 are their opposites.
+        float offset1X = widthCos + heightSin;
+        float offset1Y = widthSin - heightCos;
+        float offset2X = widthCos - heightSin;
+        float offset2Y = widthSin + heightCos;
+
+        Vertex2* quadCorners = corners + 4 * i;
+
+        quadCorners[0].x = x[i] - offset2X;
+        quadCorners[0].y = y[i] - offset2Y;
+
+        quadCorners[1].x = x[i] + offset1X;
+        quadCorners[1].y = y[i] + offset1Y;
+
+        quadCorners[2].x = x[i] + offset2X;
+        quadCorners[2].y = y[i] + offset2Y;
+
+        quadCorners[3].x = x[i] - offset1X;
+        quadCorners[3].y = y[i] - offset1Y;
+    }
+}
+
+// The rotated corners are the center plus or minus two offsets, so the bounding
+// box reaches as far as the larger of their magnitudes in each axis:
+// |w cos| + |h sin| across and |w sin| + |h cos| down.
+static int cullQuadsScalar(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, const CullRect& rect, uint8_t* visible)
+{
+    int visibleCount = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        float sinTheta;
+        float cosTheta;
+
+        sinCosDegrees(rotationDegrees[i], sinTheta, cosTheta);
+
+        float scaledHalfWidth = halfWidth * scale[i];
+        float scaledHalfHeight = halfHeight * scale[i];
+
+        float extentX = std::fabs(scaledHalfWidth * cosTheta) + std::fabs(scaledHalfHeight * sinTheta);
+        float extentY = std::fabs(scaledHalfWidth * sinTheta) + std::fabs(scaledHalfHeight * cosTheta);
+
+        bool inside = (x[i] + extentX >= rect.minX) && (x[i] - extentX <= rect.maxX) &&
+                      (y[i] + extentY >= rect.minY) && (y[i] - extentY <= rect.maxY);
+
+        visible[i] = inside ? 1 : 0;
+
+        visibleCount += visible[i];
+    }
+
+    return visibleCount;
+}
+
+#ifdef TRANSFORM_X86
+
+static bool cpuSupportsAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // The OS must save the YMM registers too.
+    __cpuid(info, 1);
+
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool cpuSupportsSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 1);
+
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+TARGET_SSE2 static void sinCosDegreesSse2(__m128 degrees, __m128& sinTheta, __m128& cosTheta)
+{
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(degrees, _mm_set1_ps(1.0f / 90.0f)));
+
+    __m128 radians = _mm_sub_ps(degrees, _mm_mul_ps(_mm_cvtepi32_ps(quadrant), _mm_set1_ps(90.0f)));
+    radians = _mm_mul_ps(radians, _mm_set1_ps(degreesToRadians));
+
+    __m128 radians2 = _mm_mul_ps(radians, radians);
+
+    __m128 sinValue = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sinCoefficient2), radians2), _mm_set1_ps(sinCoefficient1));
+    sinValue = _mm_add_ps(_mm_mul_ps(sinValue, radians2), _mm_set1_ps(sinCoefficient0));
+    sinValue = _mm_mul_ps(_mm_mul_ps(sinValue, radians2), radians);
+    sinValue = _mm_add_ps(sinValue, radians);
+
+    __m128 cosValue = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cosCoefficient2), radians2), _mm_set1_ps(cosCoefficient1));
+    cosValue = _mm_add_ps(_mm_mul_ps(cosValue, radians2), _mm_set1_ps(cosCoefficient0));
+    cosValue = _mm_mul_ps(_mm_mul_ps(cosValue, radians2), radians2);
+    cosValue = _mm_sub_ps(cosValue, _mm_mul_ps(_mm_set1_ps(0.5f), radians2));
+    cosValue = _mm_add_ps(cosValue, _mm_set1_ps(1.0f));
+
+    __m128i one = _mm_set1_epi32(1);
+    __m128i two = _mm_set1_epi32(2);
+
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+
+    // Bit 1 of the quadrant moved to the sign bit.
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+    sinTheta = _mm_or_ps(_mm_and_ps(swap, cosValue), _mm_andnot_ps(swap, sinValue));
+    cosTheta = _mm_or_ps(_mm_and_ps(swap, sinValue), _mm_andnot_ps(swap, cosValue));
+
+    sinTheta = _mm_xor_ps(sinTheta, sinSign);
+    cosTheta = _mm_xor_ps(cosTheta, cosSign);
+}
+
+TARGET_SSE2 static int transformQuadCornersSse2(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, Vertex2* corners)
+{
+    float* out = &corners[0].x;
+
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 sinTheta;
+        __m128 cosTheta;
+
+        sinCosDegreesSse2(_mm_loadu_ps(rotationDegrees + i), sinTheta, cosTheta);
+
+        __m128 quadScale = _mm_loadu_ps(scale + i);
+
+        __m128 scaledHalfWidth = _mm_mul_ps(_mm_set1_ps(halfWidth), quadScale);
+        __m128 scaledHalfHeight = _mm_mul_ps(_mm_set1_ps(halfHeight), quadScale);
+
+        __m128 widthCos = _mm_mul_ps(scaledHalfWidth, cosTheta);
+        __m128 widthSin = _mm_mul_ps(scaledHalfWidth, sinTheta);
+        __m128 heightCos = _mm_mul_ps(scaledHalfHeight, cosTheta);
+        __m128 heightSin = _mm_mul_ps(scaledHalfHeight, sinTheta);
+
+        __m128 offset1X = _mm_add_ps(widthCos, heightSin);
+        __m128 offset1Y = _mm_sub_ps(widthSin, heightCos);
+        __m128 offset2X = _mm_sub_ps(widthCos, heightSin);
+        __m128 offset2Y = _mm_add_ps(widthSin, heightCos);
+
+        __m128 centerX = _mm_loadu_ps(x + i);
+        __m128 centerY = _mm_loadu_ps(y + i);
+
+        // Each register holds one corner of the 4 quads.
+        __m128 corner0X = _mm_sub_ps(centerX, offset2X);
+        __m128 corner0Y = _mm_sub_ps(centerY, offset2Y);
+        __m128 corner1X = _mm_add_ps(centerX, offset1X);
+        __m128 corner1Y = _mm_add_ps(centerY, offset1Y);
+        __m128 corner2X = _mm_add_ps(centerX, offset2X);
+        __m128 corner2Y = _mm_add_ps(centerY, offset2Y);
+        __m128 corner3X = _mm_sub_ps(centerX, offset1X);
+        __m128 corner3Y = _mm_sub_ps(centerY, offset1Y);
+
+        // Transpose to x, y pairs: the low halves hold quads 0 and 1, the high halves quads 2 and 3.
+        __m128 corner0Low = _mm_unpacklo_ps(corner0X, corner0Y);
+        __m128 corner0High = _mm_unpackhi_ps(corner0X, corner0Y);
+        __m128 corner1Low = _mm_unpacklo_ps(corner1X, corner1Y);
+        __m128 corner1High = _mm_unpackhi_ps(corner1X, corner1Y);
+        __m128 corner2Low = _mm_unpacklo_ps(corner2X, corner2Y);
+        __m128 corner2High = _mm_unpackhi_ps(corner2X, corner2Y);
+        __m128 corner3Low = _mm_unpacklo_ps(corner3X, corner3Y);
+        __m128 corner3High = _mm_unpackhi_ps(corner3X, corner3Y);
+
+        float* quadOut = out + 8 * i;
+
+        _mm_storeu_ps(quadOut,      _mm_movelh_ps(corner0Low, corner1Low));
+        _mm_storeu_ps(quadOut + 4,  _mm_movelh_ps(corner2Low, corner3Low));
+        _mm_storeu_ps(quadOut + 8,  _mm_movehl_ps(corner1Low, corner0Low));
+        _mm_storeu_ps(quadOut + 12, _mm_movehl_ps(corner3Low, corner2Low));
+        _mm_storeu_ps(quadOut + 16, _mm_movelh_ps(corner0High, corner1High));
+        _mm_storeu_ps(quadOut + 20, _mm_movelh_ps(corner2High, corner3High));
+        _mm_storeu_ps(quadOut + 24, _mm_movehl_ps(corner1High, corner0High));
+        _mm_storeu_ps(quadOut + 28, _mm_movehl_ps(corner3High, corner2High));
+    }
+
+    return i;
+}
+
+// Cull 4 quads per iteration, the same steps as cullQuadsScalar(). Returns the
+// number of quads done and adds the visible ones to visibleCount.
+TARGET_SSE2 static int cullQuadsSse2(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, const CullRect& rect, uint8_t* visible, int& visibleCount)
+{
+    // Clearing the sign bit is fabs().
+    __m128 signBit = _mm_set1_ps(-0.0f);
+
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 sinTheta;
+        __m128 cosTheta;
+
+        sinCosDegreesSse2(_mm_loadu_ps(rotationDegrees + i), sinTheta, cosTheta);
+
+        __m128 quadScale = _mm_loadu_ps(scale + i);
+
+        __m128 scaledHalfWidth = _mm_mul_ps(_mm_set1_ps(halfWidth), quadScale);
+        __m128 scaledHalfHeight = _mm_mul_ps(_mm_set1_ps(halfHeight), quadScale);
+
+        __m128 extentX = _mm_add_ps(_mm_andnot_ps(signBit, _mm_mul_ps(scaledHalfWidth, cosTheta)), _mm_andnot_ps(signBit, _mm_mul_ps(scaledHalfHeight, sinTheta)));
+        __m128 extentY = _mm_add_ps(_mm_andnot_ps(signBit, _mm_mul_ps(scaledHalfWidth, sinTheta)), _mm_andnot_ps(signBit, _mm_mul_ps(scaledHalfHeight, cosTheta)));
+
+        __m128 centerX = _mm_loadu_ps(x + i);
+        __m128 centerY = _mm_loadu_ps(y + i);
+
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(centerX, extentX), _mm_set1_ps(rect.minX)),
+                                   _mm_cmple_ps(_mm_sub_ps(centerX, extentX), _mm_set1_ps(rect.maxX)));
+
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(centerY, extentY), _mm_set1_ps(rect.minY)));
+        inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_sub_ps(centerY, extentY), _mm_set1_ps(rect.maxY)));
+
+        int mask = _mm_movemask_ps(inside);
+
+        for (int lane = 0; lane < 4; lane++)
+        {
+            visible[i + lane] = (mask >> lane) & 1;
+
+            visibleCount += visible[i + lane];
+        }
+    }
+
+    return i;
+}
+
+TARGET_AVX2 static void sinCosDegreesAvx2(__m256 degrees, __m256& sinTheta, __m256& cosTheta)
+{
+    __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(degrees, _mm256_set1_ps(1.0f / 90.0f)));
+
+    __m256 radians = _mm256_sub_ps(degrees, _mm256_mul_ps(_mm256_cvtepi32_ps(quadrant), _mm256_set1_ps(90.0f)));
+    radians = _mm256_mul_ps(radians, _mm256_set1_ps(degreesToRadians));
+
+    __m256 radians2 = _mm256_mul_ps(radians, radians);
+
+    __m256 sinValue = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(sinCoefficient2), radians2), _mm256_set1_ps(sinCoefficient1));
+    sinValue = _mm256_add_ps(_mm256_mul_ps(sinValue, radians2), _mm256_set1_ps(sinCoefficient0));
+    sinValue = _mm256_mul_ps(_mm256_mul_ps(sinValue, radians2), radians);
+    sinValue = _mm256_add_ps(sinValue, radians);
+
+    __m256 cosValue = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(cosCoefficient2), radians2), _mm256_set1_ps(cosCoefficient1));
+    cosValue = _mm256_add_ps(_mm256_mul_ps(cosValue, radians2), _mm256_set1_ps(cosCoefficient0));
+    cosValue = _mm256_mul_ps(_mm256_mul_ps(cosValue, radians2), radians2);
+    cosValue = _mm256_sub_ps(cosValue, _mm256_mul_ps(_mm256_set1_ps(0.5f), radians2));
+    cosValue = _mm256_add_ps(cosValue, _mm256_set1_ps(1.0f));
+
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i two = _mm256_set1_epi32(2);
+
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+
+    sinTheta = _mm256_xor_ps(_mm256_blendv_ps(sinValue, cosValue, swap), sinSign);
+    cosTheta = _mm256_xor_ps(_mm256_blendv_ps(cosValue, sinValue, swap), cosSign);
+}
+
+TARGET_AVX2 static int transformQuadCornersAvx2(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, Vertex2* corners)
+{
+    float* out = &corners[0].x;
+
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 sinTheta;
+        __m256 cosTheta;
+
+        sinCosDegreesAvx2(_mm256_loadu_ps(rotationDegrees + i), sinTheta, cosTheta);
+
+        __m256 quadScale = _mm256_loadu_ps(scale + i);
+
+        __m256 scaledHalfWidth = _mm256_mul_ps(_mm256_set1_ps(halfWidth), quadScale);
+        __m256 scaledHalfHeight = _mm256_mul_ps(_mm256_set1_ps(halfHeight), quadScale);
+
+        __m256 widthCos = _mm256_mul_ps(scaledHalfWidth, cosTheta);
+        __m256 widthSin = _mm256_mul_ps(scaledHalfWidth, sinTheta);
+        __m256 heightCos = _mm256_mul_ps(scaledHalfHeight, cosTheta);
+        __m256 heightSin = _mm256_mul_ps(scaledHalfHeight, sinTheta);
+
+        __m256 offset1X = _mm256_add_ps(widthCos, heightSin);
+        __m256 offset1Y = _mm256_sub_ps(widthSin, heightCos);
+        __m256 offset2X = _mm256_sub_ps(widthCos, heightSin);
+        __m256 offset2Y = _mm256_add_ps(widthSin, heightCos);
+
+        __m256 centerX = _mm256_loadu_ps(x + i);
+        __m256 centerY = _mm256_loadu_ps(y + i);
+
+        __m256 corner0X = _mm256_sub_ps(centerX, offset2X);
+        __m256 corner0Y = _mm256_sub_ps(centerY, offset2Y);
+        __m256 corner1X = _mm256_add_ps(centerX, offset1X);
+        __m256 corner1Y = _mm256_add_ps(centerY, offset1Y);
+        __m256 corner2X = _mm256_add_ps(centerX, offset2X);
+        __m256 corner2Y = _mm256_add_ps(centerY, offset2Y);
+        __m256 corner3X = _mm256_sub_ps(centerX, offset1X);
+        __m256 corner3Y = _mm256_sub_ps(centerY, offset1Y);
+
+        // Unpacks work within 128 bit lanes: the low ones hold quads 0, 1, 4 and 5, the high ones 2, 3, 6 and 7.
+        __m256 corner0Low = _mm256_unpacklo_ps(corner0X, corner0Y);
+        __m256 corner0High = _mm256_unpackhi_ps(corner0X, corner0Y);
+        __m256 corner1Low = _mm256_unpacklo_ps(corner1X, corner1Y);
+        __m256 corner1High = _mm256_unpackhi_ps(corner1X, corner1Y);
+        __m256 corner2Low = _mm256_unpacklo_ps(corner2X, corner2Y);
+        __m256 corner2High = _mm256_unpackhi_ps(corner2X, corner2Y);
+        __m256 corner3Low = _mm256_unpacklo_ps(corner3X, corner3Y);
+        __m256 corner3High = _mm256_unpackhi_ps(corner3X, corner3Y);
+
+        // Corners 0 and 1, then 2 and 3, of quads 0 and 4, 1 and 5, 2 and 6, 3 and 7.
+        __m256 quad04Corners01 = _mm256_shuffle_ps(corner0Low, corner1Low, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 quad04Corners23 = _mm256_shuffle_ps(corner2Low, corner3Low, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 quad15Corners01 = _mm256_shuffle_ps(corner0Low, corner1Low, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 quad15Corners23 = _mm256_shuffle_ps(corner2Low, corner3Low, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 quad26Corners01 = _mm256_shuffle_ps(corner0High, corner1High, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 quad26Corners23 = _mm256_shuffle_ps(corner2High, corner3High, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 quad37Corners01 = _mm256_shuffle_ps(corner0High, corner1High, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 quad37Corners23 = _mm256_shuffle_ps(corner2High, corner3High, _MM_SHUFFLE(3, 2, 3, 2));
+
+        float* quadOut = out + 8 * i;
+
+        _mm256_storeu_ps(quadOut,      _mm256_permute2f128_ps(quad04Corners01, quad04Corners23, 0x20));
+        _mm256_storeu_ps(quadOut + 8,  _mm256_permute2f128_ps(quad15Corners01, quad15Corners23, 0x20));
+        _mm256_storeu_ps(quadOut + 16, _mm256_permute2f128_ps(quad26Corners01, quad26Corners23, 0x20));
+        _mm256_storeu_ps(quadOut + 24, _mm256_permute2f128_ps(quad37Corners01, quad37Corners23, 0x20));
+        _mm256_storeu_ps(quadOut + 32, _mm256_permute2f128_ps(quad04Corners01, quad04Corners23, 0x31));
+        _mm256_storeu_ps(quadOut + 40, _mm256_permute2f128_ps(quad15Corners01, quad15Corners23, 0x31));
+        _mm256_storeu_ps(quadOut + 48, _mm256_permute2f128_ps(quad26Corners01, quad26Corners23, 0x31));
+        _mm256_storeu_ps(quadOut + 56, _mm256_permute2f128_ps(quad37Corners01, quad37Corners23, 0x31));
+    }
+
+    return i;
+}
+
+TARGET_AVX2 static int cullQuadsAvx2(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, const CullRect& rect, uint8_t* visible, int& visibleCount)
+{
+    __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 sinTheta;
+        __m256 cosTheta;
+
+        sinCosDegreesAvx2(_mm256_loadu_ps(rotationDegrees + i), sinTheta, cosTheta);
+
+        __m256 quadScale = _mm256_loadu_ps(scale + i);
+
+        __m256 scaledHalfWidth = _mm256_mul_ps(_mm256_set1_ps(halfWidth), quadScale);
+        __m256 scaledHalfHeight = _mm256_mul_ps(_mm256_set1_ps(halfHeight), quadScale);
+
+        __m256 extentX = _mm256_add_ps(_mm256_andnot_ps(signBit, _mm256_mul_ps(scaledHalfWidth, cosTheta)), _mm256_andnot_ps(signBit, _mm256_mul_ps(scaledHalfHeight, sinTheta)));
+        __m256 extentY = _mm256_add_ps(_mm256_andnot_ps(signBit, _mm256_mul_ps(scaledHalfWidth, sinTheta)), _mm256_andnot_ps(signBit, _mm256_mul_ps(scaledHalfHeight, cosTheta)));
+
+        __m256 centerX = _mm256_loadu_ps(x + i);
+        __m256 centerY = _mm256_loadu_ps(y + i);
+
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(centerX, extentX), _mm256_set1_ps(rect.minX), _CMP_GE_OQ),
+                                      _mm256_cmp_ps(_mm256_sub_ps(centerX, extentX), _mm256_set1_ps(rect.maxX), _CMP_LE_OQ));
+
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(centerY, extentY), _mm256_set1_ps(rect.minY), _CMP_GE_OQ));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_sub_ps(centerY, extentY), _mm256_set1_ps(rect.maxY), _CMP_LE_OQ));
+
+        int mask = _mm256_movemask_ps(inside);
+
+        for (int lane = 0; lane < 8; lane++)
+        {
+            visible[i + lane] = (mask >> lane) & 1;
+
+            visibleCount += visible[i + lane];
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+bool transformKernelSupported(TransformKernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef TRANSFORM_X86
+    case TRANSFORM_KERNEL_SSE2:
+        return cpuSupportsSse2();
+
+    case TRANSFORM_KERNEL_AVX2:
+        return cpuSupportsAvx2();
+#endif
+
+    case TRANSFORM_KERNEL_AUTO:
+    case TRANSFORM_KERNEL_SCALAR:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+TransformKernel activeTransformKernel()
+{
+    // Resolved once; the CPU doesn't change.
+    static TransformKernel bestKernel = transformKernelSupported(TRANSFORM_KERNEL_AVX2) ? TRANSFORM_KERNEL_AVX2 :
+                                        transformKernelSupported(TRANSFORM_KERNEL_SSE2) ? TRANSFORM_KERNEL_SSE2 :
+                                                                                          TRANSFORM_KERNEL_SCALAR;
+
+    return (transformKernel == TRANSFORM_KERNEL_AUTO) ? bestKernel : transformKernel;
+}
+
+static void runTransformKernel(TransformKernel kernel, const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, Vertex2* corners)
+{
+    int done = 0;
+
+#ifdef TRANSFORM_X86
+    if (kernel == TRANSFORM_KERNEL_AVX2)
+    {
+        done = transformQuadCornersAvx2(x, y, rotationDegrees, scale, count, halfWidth, halfHeight, corners);
+    }
+    else if (kernel == TRANSFORM_KERNEL_SSE2)
+    {
+        done = transformQuadCornersSse2(x, y, rotationDegrees, scale, count, halfWidth, halfHeight, corners);
+    }
+#endif
+
+    // The quads left over from the vector width.
+    transformQuadCornersScalar(x + done, y + done, rotationDegrees + done, scale + done, count - done, halfWidth, halfHeight, corners + 4 * done);
+}
+
+static int runCullKernel(TransformKernel kernel, const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, const CullRect& rect, uint8_t* visible)
+{
+    int done = 0;
+
+    int visibleCount = 0;
+
+#ifdef TRANSFORM_X86
+    if (kernel == TRANSFORM_KERNEL_AVX2)
+    {
+        done = cullQuadsAvx2(x, y, rotationDegrees, scale, count, halfWidth, halfHeight, rect, visible, visibleCount);
+    }
+    else if (kernel == TRANSFORM_KERNEL_SSE2)
+    {
+        done = cullQuadsSse2(x, y, rotationDegrees, scale, count, halfWidth, halfHeight, rect, visible, visibleCount);
+    }
+#endif
+
+    return visibleCount + cullQuadsScalar(x + done, y + done, rotationDegrees + done, scale + done, count - done, halfWidth, halfHeight, rect, visible + done);
+}
+
+int cullQuads(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, const CullRect& rect, uint8_t* visible)
+{
+    return runCullKernel(activeTransformKernel(), x, y, rotationDegrees, scale, count, halfWidth, halfHeight, rect, visible);
+}
+
+void transformQuadCorners(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, Vertex2* corners)
+{
+    runTransformKernel(activeTransformKernel(), x, y, rotationDegrees, scale, count, halfWidth, halfHeight, corners);
+}
+
+void transformQuadCorners(const QuadTransformBatch& batch, float halfWidth, float halfHeight, Vertex2* corners)
+{
+    if (batch.size() == 0)
+    {
+        return;
+    }
+
+    transformQuadCorners(batch.x.data(), batch.y.data(), batch.rotationDegrees.data(), batch.scale.data(), batch.size(), halfWidth, halfHeight, corners);
+}
+
+bool setTransformKernel(std::string name)
+{
+    TransformKernel kernel;
+
+    if (name == "auto")
+    {
+        kernel = TRANSFORM_KERNEL_AUTO;
+    }
+    else if (name == "scalar")
+    {
+        kernel = TRANSFORM_KERNEL_SCALAR;
+    }
+    else if (name == "sse2")
+    {
+        kernel = TRANSFORM_KERNEL_SSE2;
+    }
+    else if (name == "avx2")
+    {
+        kernel = TRANSFORM_KERNEL_AVX2;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (transformKernelSupported(kernel) == false)
+    {
+        return false;
+    }
+
+    transformKernel = kernel;
+
+    return true;
+}
+
+const char* transformKernelName(TransformKernel kernel)
+{
+    switch (kernel)
+    {
+    case TRANSFORM_KERNEL_SCALAR:
+        return "scalar";
+
+    case TRANSFORM_KERNEL_SSE2:
+        return "sse2";
+
+    case TRANSFORM_KERNEL_AVX2:
+        return "avx2";
+
+    default:
+        return "auto";
+    }
+}
+
+bool verifyTransformKernels(const std::vector<QuadParams>& quads)
+{
+    int count = quads.size();
+
+    // The same quads addSquareQuad() would build, sized in whole pixels.
+    QuadTransformBatch batch;
+
+    batch.resize(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        float scale = (quads[i].scale <= 0.0f) ? 1.0f : quads[i].scale;
+
+        batch.x[i] = quads[i].x;
+        batch.y[i] = quads[i].y;
+        batch.rotationDegrees[i] = quads[i].rotationDegrees;
+        batch.scale[i] = (int)(50 * scale) / 2;
+    }
+
+    std::vector<Vertex2> expected(4 * count);
+
+    std::vector<Vertex2> quadCorners(4);
+
+    std::vector<Vertex2> rotatedCorners(4);
+
+    for (int i = 0; i < count; i++)
+    {
+        float halfSize = batch.scale[i];
+
+        quadCorners[0] = Vertex2{ batch.x[i] - halfSize, batch.y[i] - halfSize };
+        quadCorners[1] = Vertex2{ batch.x[i] + halfSize, batch.y[i] - halfSize };
+        quadCorners[2] = Vertex2{ batch.x[i] + halfSize, batch.y[i] + halfSize };
+        quadCorners[3] = Vertex2{ batch.x[i] - halfSize, batch.y[i] + halfSize };
+
+        rotatePoints(batch.rotationDegrees[i], quadCorners, rotatedCorners, Vertex2{ batch.x[i], batch.y[i] });
+
+        std::copy(rotatedCorners.begin(), rotatedCorners.end(), expected.begin() + 4 * i);
+    }
+
+    const TransformKernel kernels[] = { TRANSFORM_KERNEL_SCALAR, TRANSFORM_KERNEL_SSE2, TRANSFORM_KERNEL_AVX2 };
+
+    std::vector<Vertex2> corners(4 * count);
+
+    std::vector<Vertex2> scalarCorners;
+
+    // Culled against what the default camera shows less a margin, so quads straddle every edge.
+    CullRect cullRect = { 100.0f - screenWidth / 2, 100.0f - screenHeight / 2, screenWidth / 2 - 100.0f, screenHeight / 2 - 100.0f };
+
+    std::vector<uint8_t> visible(count);
+
+    std::vector<uint8_t> scalarVisible;
+
+    bool ok = true;
+
+    for (TransformKernel kernel : kernels)
+    {
+        if (transformKernelSupported(kernel) == false)
+        {
+            std::cout << transformKernelName(kernel) << ": not supported by this CPU" << std::endl;
+
+            continue;
+        }
+
+        // Best of a few runs, the first of which also warms the caches.
+        double bestMs = 0.0;
+
+        for (int run = 0; run < 5; run++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            runTransformKernel(kernel, batch.x.data(), batch.y.data(), batch.rotationDegrees.data(), batch.scale.data(), count, 1.0f, 1.0f, corners.data());
+
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            bestMs = (run == 0) ? ms : std::min(bestMs, ms);
+        }
+
+        int visibleCount = runCullKernel(kernel, batch.x.data(), batch.y.data(), batch.rotationDegrees.data(), batch.scale.data(), count, 1.0f, 1.0f, cullRect, visible.data());
+
+        float maxError = 0.0f;
+
+        bool identical = (scalarVisible.empty() == true) || (visible == scalarVisible);
+
+        for (int i = 0; i < 4 * count; i++)
+        {
+            maxError = std::max(maxError, std::fabs(corners[i].x - expected[i].x));
+            maxError = std::max(maxError, std::fabs(corners[i].y - expected[i].y));
+
+            if (scalarCorners.empty() == false)
+            {
+                identical &= (corners[i].x == scalarCorners[i].x) && (corners[i].y == scalarCorners[i].y);
+            }
+        }
+
+        if (kernel == TRANSFORM_KERNEL_SCALAR)
+        {
+            scalarCorners = corners;
+            scalarVisible = visible;
+        }
+
+        bool passed = (maxError <= transformTolerance) && identical;
+
+        std::cout << transformKernelName(kernel) << ": " << count << " quads, max error " << maxError << " px, "
+                  << (identical ? "" : "differs from scalar, ")
+                  << (bestMs > 0.0 ? count / bestMs : 0.0) << " quads/ms, " << visibleCount << " visible" << (passed ? "" : " FAILED") << std::endl;
+
+        ok &= passed;
+    }
+
+    return ok;
+}
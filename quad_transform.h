@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "testbed.h"
+
+// Which kernel transformQuadCorners() runs.
+enum TransformKernel
+{
+    // The widest kernel the CPU supports.
+    TRANSFORM_KERNEL_AUTO,
+
+    // Portable C++, one quad at a time.
+    TRANSFORM_KERNEL_SCALAR,
+
+    // 4 quads per iteration.
+    TRANSFORM_KERNEL_SSE2,
+
+    // 8 quads per iteration.
+    TRANSFORM_KERNEL_AVX2
+};
+
+extern TransformKernel transformKernel;
+
+// Parameters of a batch of quads, one array per parameter.
+struct QuadTransformBatch
+{
+    // Centers in world units.
+    std::vector<float>  x;
+    std::vector<float>  y;
+
+    std::vector<float>  rotationDegrees;
+
+    // Multiplies the batch's half size.
+    std::vector<float>  scale;
+
+    void resize(size_t count);
+
+    size_t size() const { return x.size(); }
+};
+
+// Write the four corners of each quad, in the order addQuad() emits them, to
+// corners[4 * i] to corners[4 * i + 3]. Quad i is halfWidth * scale[i] by
+// halfHeight * scale[i] pixels each side of its center, rotated about it.
+// Every kernel gives bit identical results, within a hundredth of a pixel of rotatePoints().
+void transformQuadCorners(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, Vertex2* corners);
+
+void transformQuadCorners(const QuadTransformBatch& batch, float halfWidth, float halfHeight, Vertex2* corners);
+
+// An axis aligned rectangle in world units, which culling keeps the quads overlapping.
+struct CullRect
+{
+    float   minX;
+    float   minY;
+    float   maxX;
+    float   maxY;
+};
+
+// Set visible[i] to 1 when the bounding box of quad i, rotated as
+// transformQuadCorners() would, overlaps rect, and to 0 when it misses. Runs
+// the transformKernel's width, and every kernel gives the same answers.
+// Returns the number of visible quads.
+int cullQuads(const float* x, const float* y, const float* rotationDegrees, const float* scale, int count, float halfWidth, float halfHeight, const CullRect& rect, uint8_t* visible);
+
+// Select the kernel by name: auto, scalar, sse2 or avx2. Returns false for an
+// unknown name or one the CPU can't run.
+bool setTransformKernel(std::string name);
+
+const char* transformKernelName(TransformKernel kernel);
+
+bool transformKernelSupported(TransformKernel kernel);
+
+// What transformKernel resolves to on this CPU.
+TransformKernel activeTransformKernel();
+
+// Transform the scene with each supported kernel, compare the corners with
+// rotatePoints() and print the worst error and the throughput. Also culls the
+// scene against the screen with each. Returns false if any kernel strays from
+// the reference, or culls differently from the scalar one.
+bool verifyTransformKernels(const std::vector<QuadParams>& quads);
@@ -0,0 +1,18 @@
+#pragma once
+
+// One of the testbed pipelines. The driver calls init() once, then
+// buildScene() and renderFrame() every frame, then shutdown(). With
+// retainedQuads, buildScene() is only called for the first frame.
+struct RenderPath
+{
+    const char*     name;
+    bool            (*init)();
+    void            (*buildScene)();
+    void            (*renderFrame)();
+    void            (*shutdown)();
+};
+
+extern RenderPath singleQuadPath;
+extern RenderPath renderToTexturePath;
+extern RenderPath silhouetteBufferPath;
+extern RenderPath integerTexturePath;
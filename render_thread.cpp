@@ -0,0 +1,683 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "camera.h"
+#include "profiler.h"
+#include "quad_groups.h"
+#include "quad_store.h"
+#include "render_thread.h"
+#include "screen.h"
+#include "testbed.h"
+
+bool            renderThreadEnabled = false;
+
+// One frame of commands, plus the quad data its uploads copied. The ranges'
+// data starts at their offsets in the payload until the list is submitted,
+// when the payload has stopped growing and they are pointed at it. Group draws
+// copy their runs into drawRanges.
+struct RenderCommandList
+{
+    std::vector<RenderCommand>      commands;
+    StagingVector<unsigned char>    payload;
+    std::vector<QuadRange>          quadRanges;
+    std::vector<size_t>             quadRangeOffsets;
+    std::vector<QuadDrawRange>      drawRanges;
+};
+
+enum RenderThreadState
+{
+    RENDER_THREAD_STARTING,
+    RENDER_THREAD_RUNNING,
+    RENDER_THREAD_FAILED
+};
+
+static RenderCommandList            commandLists[renderCommandListCount];
+static std::thread                  renderThread;
+
+// Only the main thread reads these. While running, recorded commands go to recordingList.
+static bool                         renderThreadRunning = false;
+static RenderCommandList*           recordingList = NULL;
+
+// The handoff between the main thread, which only writes submittedLists, and
+// the render thread, which only writes executedLists. List n lives in
+// commandLists[n % renderCommandListCount]; it is the main thread's again once
+// executedLists has passed it, so the lists themselves are never locked.
+static std::atomic<uint64_t>        submittedLists(0);
+static std::atomic<uint64_t>        executedLists(0);
+
+static std::atomic<int>             renderThreadState(RENDER_THREAD_STARTING);
+static std::atomic<bool>            renderThreadStopping(false);
+
+// A side with nothing to do sleeps on handoffChanged until the other changes
+// one of the atomics above, rather than spinning a core the job threads want.
+static std::mutex                   handoffMutex;
+static std::condition_variable      handoffChanged;
+
+// Wake the other side after changing one of the handoff atomics. Taking the
+// mutex orders the change before a waiter's check, so the wakeup isn't lost.
+static void notifyHandoff()
+{
+    {
+        std::lock_guard<std::mutex> lock(handoffMutex);
+    }
+
+    handoffChanged.notify_all();
+}
+
+template <typename Predicate>
+static void waitForHandoff(Predicate ready)
+{
+    if (ready() == true)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(handoffMutex);
+
+    handoffChanged.wait(lock, ready);
+}
+
+static void executeRenderCommand(const RenderCommandList* list, const RenderCommand& command)
+{
+    switch (command.type)
+    {
+    case RENDER_BIND_FRAMEBUFFER:
+        glBindFramebuffer(GL_FRAMEBUFFER, command.id);
+        break;
+
+    case RENDER_VIEWPORT:
+        glViewport(command.rect[0], command.rect[1], command.rect[2], command.rect[3]);
+        break;
+
+    case RENDER_CLEAR:
+        glClearColor(command.color[0], command.color[1], command.color[2], command.color[3]);
+        glClear(command.mask);
+        break;
+
+    case RENDER_ENABLE:
+        glEnable(command.target);
+        break;
+
+    case RENDER_DISABLE:
+        glDisable(command.target);
+        break;
+
+    case RENDER_USE_PROGRAM:
+        glUseProgram(command.id);
+        break;
+
+    case RENDER_BIND_TEXTURE:
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(command.target, command.id);
+        break;
+
+    case RENDER_BIND_VERTEX_ARRAY:
+        glBindVertexArray(command.id);
+        break;
+
+    case RENDER_UPDATE_QUADS:
+        // Recorded lists carry their own copy, immediate commands point at the staging vectors.
+        if (list != NULL && command.quadCount > 0)
+        {
+            updateVbo(*command.shader, &list->payload[command.payloadOffset], command.quadCount);
+        }
+        else
+        {
+            updateVbo(*command.shader, command.data, command.quadCount);
+        }
+        break;
+
+    case RENDER_UPDATE_QUAD_RANGES:
+        if (list != NULL)
+        {
+            updateVboRanges(*command.shader, command.quadCount, list->quadRanges.data() + command.firstRange, command.rangeCount);
+        }
+        else
+        {
+            updateVboRanges(*command.shader, command.quadCount, command.shader->dirtyRanges.data(), command.rangeCount);
+        }
+        break;
+
+    case RENDER_SET_VIEW_MATRIX:
+        if (list != NULL)
+        {
+            glUniformMatrix4fv(command.shader->modelViewMatrixLocation, 1, GL_FALSE, (const GLfloat*)&list->payload[command.payloadOffset]);
+        }
+        else
+        {
+            glUniformMatrix4fv(command.shader->modelViewMatrixLocation, 1, GL_FALSE, (const GLfloat*)command.data);
+        }
+        break;
+
+    case RENDER_DRAW_QUADS:
+        drawQuads(*command.shader, command.quadCount);
+        break;
+
+    case RENDER_DRAW_QUAD_GROUPS:
+        if (list != NULL)
+        {
+            drawQuadGroups(*command.shader, list->drawRanges.data() + command.firstRange, command.rangeCount);
+        }
+        else
+        {
+            drawQuadGroups(*command.shader, command.shader->groupDrawRanges.data(), command.rangeCount);
+        }
+        break;
+
+    case RENDER_BEGIN_PROFILE_SCOPE:
+        beginProfileScope(command.name);
+        break;
+
+    case RENDER_END_PROFILE_SCOPE:
+        endProfileScope();
+        break;
+
+    case RENDER_CALL:
+        command.function(command.callData);
+        break;
+    }
+}
+
+static void renderThreadMain()
+{
+    if (makeContextCurrent() == false)
+    {
+        std::cout << "Render thread could not make the GL context current" << std::endl;
+
+        renderThreadState = RENDER_THREAD_FAILED;
+
+        notifyHandoff();
+
+        return;
+    }
+
+    renderThreadState = RENDER_THREAD_RUNNING;
+
+    notifyHandoff();
+
+    for (;;)
+    {
+        uint64_t executed = executedLists.load(std::memory_order_relaxed);
+
+        // Acquire, so the list's commands are visible once its submission is.
+        if (executed == submittedLists.load(std::memory_order_acquire))
+        {
+            if (renderThreadStopping.load() == true && executed == submittedLists.load(std::memory_order_acquire))
+            {
+                break;
+            }
+
+            waitForHandoff([=] { return renderThreadStopping.load() == true || submittedLists.load(std::memory_order_acquire) != executed; });
+
+            continue;
+        }
+
+        const RenderCommandList& list = commandLists[executed % renderCommandListCount];
+
+        for (size_t i = 0; i < list.commands.size(); i++)
+        {
+            executeRenderCommand(&list, list.commands[i]);
+        }
+
+        // Release, so the main thread only reuses the list once it's done with.
+        executedLists.store(executed + 1, std::memory_order_release);
+
+        notifyHandoff();
+    }
+
+    releaseContext();
+}
+
+bool startRenderThread()
+{
+    if (renderThreadEnabled == false || renderThreadRunning == true)
+    {
+        return true;
+    }
+
+    // Whatever the main thread queued has to reach the GPU before another thread takes over.
+    glFlush();
+
+    releaseContext();
+
+    renderThreadState = RENDER_THREAD_STARTING;
+    renderThreadStopping = false;
+
+    renderThread = std::thread(renderThreadMain);
+
+    waitForHandoff([] { return renderThreadState.load() != RENDER_THREAD_STARTING; });
+
+    if (renderThreadState.load() == RENDER_THREAD_FAILED)
+    {
+        renderThread.join();
+
+        makeContextCurrent();
+
+        return false;
+    }
+
+    renderThreadRunning = true;
+
+    return true;
+}
+
+void stopRenderThread()
+{
+    if (renderThreadRunning == false)
+    {
+        return;
+    }
+
+    renderThreadStopping = true;
+
+    notifyHandoff();
+
+    renderThread.join();
+
+    renderThreadRunning = false;
+    recordingList = NULL;
+
+    makeContextCurrent();
+}
+
+void beginRenderCommands()
+{
+    if (renderThreadRunning == false)
+    {
+        return;
+    }
+
+    uint64_t submitted = submittedLists.load(std::memory_order_relaxed);
+
+    // Wait for the render thread to finish with the list this one reuses.
+    waitForHandoff([=] { return submitted - executedLists.load(std::memory_order_acquire) < renderCommandListCount; });
+
+    recordingList = &commandLists[submitted % renderCommandListCount];
+
+    recordingList->commands.clear();
+    recordingList->payload.clear();
+    recordingList->quadRanges.clear();
+    recordingList->quadRangeOffsets.clear();
+    recordingList->drawRanges.clear();
+}
+
+void submitRenderCommands()
+{
+    if (renderThreadRunning == false || recordingList == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < recordingList->quadRanges.size(); i++)
+    {
+        recordingList->quadRanges[i].data = &recordingList->payload[recordingList->quadRangeOffsets[i]];
+    }
+
+    submittedLists.store(submittedLists.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    notifyHandoff();
+
+    recordingList = NULL;
+}
+
+void finishRenderCommands()
+{
+    if (renderThreadRunning == false)
+    {
+        return;
+    }
+
+    waitForHandoff([] { return executedLists.load(std::memory_order_acquire) == submittedLists.load(std::memory_order_relaxed); });
+}
+
+// Run the command now without a render thread, otherwise add it to the list being recorded.
+static void recordCommand(const RenderCommand& command)
+{
+    if (renderThreadRunning == false)
+    {
+        executeRenderCommand(NULL, command);
+
+        return;
+    }
+
+    if (recordingList == NULL)
+    {
+        beginRenderCommands();
+    }
+
+    recordingList->commands.push_back(command);
+}
+
+static RenderCommand renderCommand(RenderCommandType type)
+{
+    RenderCommand command;
+
+    memset(&command, 0, sizeof(command));
+
+    command.type = type;
+
+    return command;
+}
+
+void recordBindFramebuffer(GLuint frameBufferId)
+{
+    RenderCommand command = renderCommand(RENDER_BIND_FRAMEBUFFER);
+
+    command.id = frameBufferId;
+
+    recordCommand(command);
+}
+
+void recordViewport(GLint x, GLint y, GLint width, GLint height)
+{
+    RenderCommand command = renderCommand(RENDER_VIEWPORT);
+
+    command.rect[0] = x;
+    command.rect[1] = y;
+    command.rect[2] = width;
+    command.rect[3] = height;
+
+    recordCommand(command);
+}
+
+void recordClear(GLfloat r, GLfloat g, GLfloat b, GLfloat a, GLbitfield mask)
+{
+    RenderCommand command = renderCommand(RENDER_CLEAR);
+
+    command.color[0] = r;
+    command.color[1] = g;
+    command.color[2] = b;
+    command.color[3] = a;
+    command.mask = mask;
+
+    recordCommand(command);
+}
+
+void recordEnable(GLenum capability)
+{
+    RenderCommand command = renderCommand(RENDER_ENABLE);
+
+    command.target = capability;
+
+    recordCommand(command);
+}
+
+void recordDisable(GLenum capability)
+{
+    RenderCommand command = renderCommand(RENDER_DISABLE);
+
+    command.target = capability;
+
+    recordCommand(command);
+}
+
+void recordUseProgram(GLuint programId)
+{
+    RenderCommand command = renderCommand(RENDER_USE_PROGRAM);
+
+    command.id = programId;
+
+    recordCommand(command);
+}
+
+void recordBindTexture(GLenum target, GLuint textureId)
+{
+    RenderCommand command = renderCommand(RENDER_BIND_TEXTURE);
+
+    command.target = target;
+    command.id = textureId;
+
+    recordCommand(command);
+}
+
+void recordBindVertexArray(GLuint vertexArrayId)
+{
+    RenderCommand command = renderCommand(RENDER_BIND_VERTEX_ARRAY);
+
+    command.id = vertexArrayId;
+
+    recordCommand(command);
+}
+
+static void recordUpdateQuadRanges(Shader& shader)
+{
+    RenderCommand command = renderCommand(RENDER_UPDATE_QUAD_RANGES);
+
+    command.shader = &shader;
+    command.quadCount = getQuadCount(shader);
+    command.rangeCount = collectDirtyQuadRanges(shader);
+
+    if (renderThreadRunning == true && command.rangeCount > 0)
+    {
+        if (recordingList == NULL)
+        {
+            beginRenderCommands();
+        }
+
+        // Only the dirty quads are copied, the render thread's VBO has the rest.
+        size_t quadBytes = getBytesPerQuad();
+
+        command.firstRange = recordingList->quadRanges.size();
+
+        for (int i = 0; i < command.rangeCount; i++)
+        {
+            const QuadRange& range = shader.dirtyRanges[i];
+
+            size_t offset = recordingList->payload.size();
+
+            size_t bytes = range.count * quadBytes;
+
+            recordingList->payload.resize(offset + bytes);
+
+            memcpy(&recordingList->payload[offset], range.data, bytes);
+
+            recordingList->quadRanges.push_back(range);
+            recordingList->quadRangeOffsets.push_back(offset);
+        }
+    }
+
+    recordCommand(command);
+}
+
+void recordUpdateQuads(Shader& shader)
+{
+    if (shader.retained == true)
+    {
+        recordUpdateQuadRanges(shader);
+
+        return;
+    }
+
+    RenderCommand command = renderCommand(RENDER_UPDATE_QUADS);
+
+    command.shader = &shader;
+    command.quadCount = getQuadCount(shader);
+
+    if (renderThreadRunning == false)
+    {
+        command.data = getQuadData(shader);
+    }
+    else if (command.quadCount > 0)
+    {
+        if (recordingList == NULL)
+        {
+            beginRenderCommands();
+        }
+
+        // The staging vectors are rebuilt while the render thread uploads, so it gets a copy.
+        size_t bytes = getQuadDataBytes(shader);
+
+        StagingVector<unsigned char>& payload = recordingList->payload;
+
+        command.payloadOffset = payload.size();
+
+        payload.resize(command.payloadOffset + bytes);
+
+        memcpy(&payload[command.payloadOffset], getQuadData(shader), bytes);
+    }
+
+    recordCommand(command);
+}
+
+// Send the camera's view to the shader, if it doesn't have it yet. Moving the
+// camera costs this one uniform upload per shader, the quads stay as they are.
+static void recordViewMatrix(Shader& shader)
+{
+    if (shader.viewVersion == getCameraVersion())
+    {
+        return;
+    }
+
+    shader.viewVersion = getCameraVersion();
+
+    RenderCommand command = renderCommand(RENDER_SET_VIEW_MATRIX);
+
+    command.shader = &shader;
+
+    if (renderThreadRunning == false)
+    {
+        command.data = glm::value_ptr(modelViewMatrix);
+    }
+    else
+    {
+        if (recordingList == NULL)
+        {
+            beginRenderCommands();
+        }
+
+        // The camera may move again before the render thread gets here.
+        StagingVector<unsigned char>& payload = recordingList->payload;
+
+        command.payloadOffset = payload.size();
+
+        payload.resize(command.payloadOffset + sizeof(glm::mat4));
+
+        memcpy(&payload[command.payloadOffset], glm::value_ptr(modelViewMatrix), sizeof(glm::mat4));
+    }
+
+    recordCommand(command);
+}
+
+static void recordDrawQuadGroups(Shader& shader)
+{
+    RenderCommand command = renderCommand(RENDER_DRAW_QUAD_GROUPS);
+
+    command.shader = &shader;
+    command.quadCount = getQuadCount(shader);
+    command.rangeCount = collectQuadGroupDrawRanges(shader, command.quadCount);
+
+    if (renderThreadRunning == true && command.rangeCount > 0)
+    {
+        if (recordingList == NULL)
+        {
+            beginRenderCommands();
+        }
+
+        // The shader's runs are rebuilt for the next frame, so the render thread gets a copy.
+        command.firstRange = recordingList->drawRanges.size();
+
+        recordingList->drawRanges.insert(recordingList->drawRanges.end(), shader.groupDrawRanges.begin(), shader.groupDrawRanges.end());
+    }
+
+    recordCommand(command);
+}
+
+void recordDrawQuads(Shader& shader)
+{
+    recordViewMatrix(shader);
+
+    if (groupedDraws == true)
+    {
+        recordDrawQuadGroups(shader);
+
+        return;
+    }
+
+    RenderCommand command = renderCommand(RENDER_DRAW_QUADS);
+
+    command.shader = &shader;
+    command.quadCount = getQuadCount(shader);
+
+    recordCommand(command);
+}
+
+void recordBeginProfileScope(const char* name)
+{
+    RenderCommand command = renderCommand(RENDER_BEGIN_PROFILE_SCOPE);
+
+    command.name = name;
+
+    recordCommand(command);
+}
+
+void recordEndProfileScope()
+{
+    recordCommand(renderCommand(RENDER_END_PROFILE_SCOPE));
+}
+
+void recordCall(void (*function)(void* data), void* data)
+{
+    RenderCommand command = renderCommand(RENDER_CALL);
+
+    command.function = function;
+    command.callData = data;
+
+    recordCommand(command);
+}
+
+static void presentCall(void*)
+{
+    presentFrame();
+}
+
+static void beginProfilerFrameCall(void*)
+{
+    beginProfilerFrame();
+}
+
+static void endProfilerFrameCall(void*)
+{
+    endProfilerFrame();
+}
+
+void recordPresent()
+{
+    recordCall(presentCall, NULL);
+}
+
+void recordBeginProfilerFrame()
+{
+    recordCall(beginProfilerFrameCall, NULL);
+}
+
+void recordEndProfilerFrame()
+{
+    recordCall(endProfilerFrameCall, NULL);
+}
+
+void beginMainThreadProfileScope(const char* name)
+{
+    if (renderThreadRunning == false)
+    {
+        beginProfileScope(name);
+    }
+}
+
+void endMainThreadProfileScope()
+{
+    if (renderThreadRunning == false)
+    {
+        endProfileScope();
+    }
+}
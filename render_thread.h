@@ -0,0 +1,144 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "testbed.h"
+
+// When set, GL work runs on a render thread that owns the context, from
+// command lists the main thread records, so the main thread can record frame
+// N + 1 while the render thread draws frame N. When not, commands run as they
+// are recorded and uploads read the staging vectors directly.
+extern bool            renderThreadEnabled;
+
+// Command lists in flight: one recording while the other is drawn.
+const int renderCommandListCount = 2;
+
+enum RenderCommandType
+{
+    RENDER_BIND_FRAMEBUFFER,
+    RENDER_VIEWPORT,
+    RENDER_CLEAR,
+    RENDER_ENABLE,
+    RENDER_DISABLE,
+    RENDER_USE_PROGRAM,
+    RENDER_BIND_TEXTURE,
+    RENDER_BIND_VERTEX_ARRAY,
+
+    // Upload a shader's quads, copied into the command list when recorded.
+    RENDER_UPDATE_QUADS,
+
+    // Upload the dirty ranges of a retained shader, copied the same way.
+    RENDER_UPDATE_QUAD_RANGES,
+
+    // Set a shader's modelViewMatrix uniform to the camera's view when
+    // recorded, copied into the command list.
+    RENDER_SET_VIEW_MATRIX,
+
+    // Draw the quads last uploaded to a shader, as many as there were when recorded.
+    RENDER_DRAW_QUADS,
+
+    // Draw the visible groups of a shader's quads, as the runs of them recorded.
+    RENDER_DRAW_QUAD_GROUPS,
+
+    RENDER_BEGIN_PROFILE_SCOPE,
+    RENDER_END_PROFILE_SCOPE,
+
+    // Call a function on the thread with the context.
+    RENDER_CALL
+};
+
+// One recorded GL operation. Which fields matter depends on the type.
+struct RenderCommand
+{
+    RenderCommandType   type;
+
+    Shader*             shader;
+
+    // GL object, capability or texture target.
+    GLuint              id;
+    GLenum              target;
+
+    GLbitfield          mask;
+    GLfloat             color[4];
+    GLint               rect[4];
+
+    // Quads to upload or draw. Uploaded data starts at payloadOffset in the command list.
+    int                 quadCount;
+    size_t              payloadOffset;
+    const void*         data;
+
+    // Dirty ranges or draw runs, from firstRange in the command list's ranges.
+    int                 firstRange;
+    int                 rangeCount;
+
+    const char*         name;
+    void                (*function)(void* data);
+    void*               callData;
+};
+
+// Move the context to a new render thread. Call with the context current, once
+// the render path is initialized; the caller can't make GL calls until
+// stopRenderThread(). Does nothing unless renderThreadEnabled is set.
+bool startRenderThread();
+
+// Let the render thread finish what was submitted, then take the context back.
+void stopRenderThread();
+
+// Start recording the next frame. With a render thread, waits until the list
+// recorded two frames ago has been drawn, so the main thread runs at most one
+// frame ahead.
+void beginRenderCommands();
+
+// Hand the recorded list to the render thread.
+void submitRenderCommands();
+
+// Wait until the render thread has run every submitted list.
+void finishRenderCommands();
+
+void recordBindFramebuffer(GLuint frameBufferId);
+
+void recordViewport(GLint x, GLint y, GLint width, GLint height);
+
+void recordClear(GLfloat r, GLfloat g, GLfloat b, GLfloat a, GLbitfield mask);
+
+void recordEnable(GLenum capability);
+
+void recordDisable(GLenum capability);
+
+void recordUseProgram(GLuint programId);
+
+// Bind to texture unit 0.
+void recordBindTexture(GLenum target, GLuint textureId);
+
+void recordBindVertexArray(GLuint vertexArrayId);
+
+// updateVbo() on the render thread, from a copy of the quads as they are now,
+// so the shader's staging vectors are free to be rebuilt for the next frame.
+// A retained shader only has its dirty ranges copied.
+void recordUpdateQuads(Shader& shader);
+
+// drawQuads() of the quads the shader has now. With groupedDraws,
+// drawQuadGroups() of its visible groups in draw order. If the camera moved
+// since the shader last had it, its view matrix is sent first, so expects the
+// shader's program bound.
+void recordDrawQuads(Shader& shader);
+
+// Profile scopes around recorded commands, timed where the commands run.
+void recordBeginProfileScope(const char* name);
+
+void recordEndProfileScope();
+
+void recordCall(void (*function)(void* data), void* data);
+
+// presentFrame() where the context is.
+void recordPresent();
+
+void recordBeginProfilerFrame();
+
+void recordEndProfilerFrame();
+
+// Profile main thread work. The profiler belongs to the thread with the
+// context, so these are skipped while a render thread runs.
+void beginMainThreadProfileScope(const char* name);
+
+void endMainThreadProfileScope();
@@ -0,0 +1,518 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <GL/glu.h>
+
+#if defined(TESTBED_HEADLESS_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#elif defined(TESTBED_HEADLESS_OSMESA)
+#include <GL/osmesa.h>
+#endif
+
+#include "SDL.h"
+
+#include "screen.h"
+
+SDL_Window*     window;
+SDL_Surface*    screen;
+SDL_Renderer*   sdlRenderer;
+SDL_GLContext   openGlContext;
+
+int             screenWidth = 1280;
+int             screenHeight = 720;
+
+bool            headless = false;
+int             frameLimit = 0;
+std::string     captureFilename;
+
+GLuint          screenFrameBufferId = 0;
+GLuint          screenColorBufferId = 0;
+GLuint          screenDepthBufferId = 0;
+
+#if defined(TESTBED_HEADLESS_EGL)
+EGLDisplay      eglDisplay = EGL_NO_DISPLAY;
+EGLContext      eglContext = EGL_NO_CONTEXT;
+#elif defined(TESTBED_HEADLESS_OSMESA)
+OSMesaContext   osMesaContext = NULL;
+std::vector<GLubyte> osMesaBuffer;
+#endif
+
+void parseScreenArgs(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+        {
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frameLimit = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+        {
+            captureFilename = argv[++i];
+        }
+    }
+
+    // There is nobody to close a headless window, so always stop eventually.
+    if (headless == true && frameLimit <= 0)
+    {
+        frameLimit = 300;
+    }
+}
+
+bool createHeadlessContext()
+{
+#if defined(TESTBED_HEADLESS_EGL)
+
+    // Render servers have no GPU, so ask Mesa for llvmpipe unless the caller chose otherwise.
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    // Prefer the surfaceless platform, which needs neither X11 nor a DRM device.
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if (getPlatformDisplay != NULL)
+    {
+        eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+
+    if (eglDisplay == EGL_NO_DISPLAY)
+    {
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    if (eglDisplay == EGL_NO_DISPLAY)
+    {
+        std::cout << "No EGL display available" << std::endl;
+
+        return false;
+    }
+
+    EGLint eglMajor = 0;
+    EGLint eglMinor = 0;
+
+    if (eglInitialize(eglDisplay, &eglMajor, &eglMinor) == EGL_FALSE)
+    {
+        std::cout << "EGL initialization failed with error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+
+        return false;
+    }
+
+    std::cout << "EGL version: " << eglMajor << "." << eglMinor << std::endl;
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,        8,
+        EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,
+        EGL_ALPHA_SIZE,      8,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint configCount = 0;
+
+    if (eglChooseConfig(eglDisplay, configAttribs, &config, 1, &configCount) == EGL_FALSE || configCount == 0)
+    {
+        std::cout << "No suitable EGL config found" << std::endl;
+
+        return false;
+    }
+
+    if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+    {
+        std::cout << "EGL does not support desktop OpenGL" << std::endl;
+
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION,       3,
+        EGL_CONTEXT_MINOR_VERSION,       3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+
+    if (eglContext == EGL_NO_CONTEXT)
+    {
+        std::cout << "EGL context creation failed with error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+
+        return false;
+    }
+
+    // Surfaceless: there is no default framebuffer, everything renders into an FBO.
+    if (eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext) == EGL_FALSE)
+    {
+        std::cout << "EGL make current failed with error: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+
+        return false;
+    }
+
+    return true;
+
+#elif defined(TESTBED_HEADLESS_OSMESA)
+
+    const int contextAttribs[] = {
+        OSMESA_FORMAT,                OSMESA_RGBA,
+        OSMESA_DEPTH_BITS,            0,
+        OSMESA_PROFILE,               OSMESA_CORE_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, 3,
+        OSMESA_CONTEXT_MINOR_VERSION, 3,
+        0
+    };
+
+    osMesaContext = OSMesaCreateContextAttribs(contextAttribs, NULL);
+
+    if (osMesaContext == NULL)
+    {
+        std::cout << "OSMesa context creation failed" << std::endl;
+
+        return false;
+    }
+
+    // OSMesa needs a client side buffer to be current, even though we render into an FBO.
+    osMesaBuffer.resize(screenWidth * screenHeight * 4);
+
+    if (OSMesaMakeCurrent(osMesaContext, &osMesaBuffer[0], GL_UNSIGNED_BYTE, screenWidth, screenHeight) == GL_FALSE)
+    {
+        std::cout << "OSMesa make current failed" << std::endl;
+
+        return false;
+    }
+
+    return true;
+
+#else
+
+    std::cout << "Headless rendering requires building with TESTBED_HEADLESS_EGL or TESTBED_HEADLESS_OSMESA" << std::endl;
+
+    return false;
+
+#endif
+}
+
+bool initScreenFbo()
+{
+    glGenFramebuffers(1, &screenFrameBufferId);
+    glBindFramebuffer(GL_FRAMEBUFFER, screenFrameBufferId);
+
+    glGenRenderbuffers(1, &screenColorBufferId);
+    glBindRenderbuffer(GL_RENDERBUFFER, screenColorBufferId);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, screenWidth, screenHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, screenColorBufferId);
+
+    glGenRenderbuffers(1, &screenDepthBufferId);
+    glBindRenderbuffer(GL_RENDERBUFFER, screenDepthBufferId);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, screenWidth, screenHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, screenDepthBufferId);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLenum drawBuffers[1] = { GL_COLOR_ATTACHMENT0 };
+
+    glDrawBuffers(1, drawBuffers);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+
+        return false;
+    }
+
+    // Leave it bound, so code that never binds a framebuffer still lands in it.
+    return true;
+}
+
+bool initOpenGl()
+{
+    if (headless == true)
+    {
+        if (createHeadlessContext() == false)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+
+        openGlContext = SDL_GL_CreateContext(window);
+
+        if (openGlContext == NULL)
+        {
+            std::cout << "OpenGL context creation failed with error: " << SDL_GetError() << std::endl;
+        }
+    }
+
+    //Initialize GLEW
+    glewExperimental = GL_TRUE;
+
+    GLenum glewError = glewInit();
+
+    // A GLX build of GLEW can't find a GLX display under EGL/OSMesa, but the GL entry points are loaded.
+    if (glewError != GLEW_OK && (headless == false || glewError != GLEW_ERROR_NO_GLX_DISPLAY))
+    {
+        std::cout << "Error initializing GLEW: " << glewGetErrorString(glewError) << std::endl;
+        return false;
+    }
+
+    // GLEW queries GL_EXTENSIONS, which is an invalid enum in a core profile.
+    glGetError();
+
+    //Make sure OpenGL 2.1 is supported
+    if (!GLEW_VERSION_2_1)
+    {
+        std::cout << "OpenGL 2.1 not supported" << std::endl;
+        return false;
+    }
+
+    std::cout << "GLEW version: " << glewGetString(GLEW_VERSION) << std::endl;
+
+    if (headless == true && initScreenFbo() == false)
+    {
+        return false;
+    }
+
+    //Set the viewport
+    glViewport(0.f, 0.f, screenWidth, screenHeight);
+
+    //Initialize clear color
+    glClearColor(0.f, 0.f, 0.f, 1.f);
+
+    //Set blending
+    glEnable(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    //Check for error
+    GLenum error = glGetError();
+
+    if (error != GL_NO_ERROR)
+    {
+        std::cout << "OpenGL renderer initialization failed with error: " << gluErrorString(error) << std::endl;
+
+        return false;
+    }
+
+    std::cout << "OpenGL version " << glGetString(GL_VERSION) << std::endl;
+    std::cout << "OpenGL renderer " << glGetString(GL_RENDERER) << std::endl;
+    std::cout << "GLSL version " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
+
+    return true;
+}
+
+bool initializeScreen()
+{
+    if (headless == true)
+    {
+        return initOpenGl();
+    }
+
+    if (window != NULL)
+    {
+        SDL_DestroyWindow(window);
+    }
+
+    // Create the window via SDL
+    window = SDL_CreateWindow("Untitled Game - Firemelon Engine",
+        SDL_WINDOWPOS_CENTERED,
+        SDL_WINDOWPOS_CENTERED,
+        screenWidth,
+        screenHeight,
+        SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL);
+
+
+    if (window == NULL)
+    {
+        std::cout << "Window creation failed with error: " << SDL_GetError() << std::endl;
+
+        return false;
+    }
+
+    SDL_ShowCursor(1);
+
+    screen = SDL_GetWindowSurface(window);
+
+    if (screen == nullptr)
+    {
+        return false;
+    }
+
+    // Create the renderer.
+    sdlRenderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+
+    if (sdlRenderer == nullptr)
+    {
+        std::cout << "Renderer creation failed with error: " << SDL_GetError() << std::endl;
+
+        return false;
+    }
+
+    if (initOpenGl() == false)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool pollQuitEvent()
+{
+    bool quit = false;
+
+    SDL_Event event;
+
+    // While there's an event to handle...
+    while (SDL_PollEvent(&event))
+    {
+        switch (event.type)
+        {
+        case SDL_QUIT:
+
+            quit = true;
+
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return quit;
+}
+
+void presentFrame()
+{
+    if (headless == true)
+    {
+        // Nothing to swap. Wait for the GPU so a frame costs what it actually costs.
+        glFinish();
+    }
+    else
+    {
+        SDL_GL_SwapWindow(window);
+    }
+}
+
+bool makeContextCurrent()
+{
+    if (headless == false)
+    {
+        return SDL_GL_MakeCurrent(window, openGlContext) == 0;
+    }
+
+#if defined(TESTBED_HEADLESS_EGL)
+    return eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext) == EGL_TRUE;
+#elif defined(TESTBED_HEADLESS_OSMESA)
+    return OSMesaMakeCurrent(osMesaContext, &osMesaBuffer[0], GL_UNSIGNED_BYTE, screenWidth, screenHeight) == GL_TRUE;
+#else
+    return false;
+#endif
+}
+
+void releaseContext()
+{
+    if (headless == false)
+    {
+        SDL_GL_MakeCurrent(window, NULL);
+
+        return;
+    }
+
+#if defined(TESTBED_HEADLESS_EGL)
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#elif defined(TESTBED_HEADLESS_OSMESA)
+    OSMesaMakeCurrent(NULL, NULL, 0, 0, 0);
+#endif
+}
+
+bool captureFrame(std::string filename)
+{
+    std::vector<GLubyte> pixels(screenWidth * screenHeight * 4);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, screenFrameBufferId);
+    glReadPixels(0, 0, screenWidth, screenHeight, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (file.is_open() == false)
+    {
+        std::cout << "Failed to open capture file " << filename << std::endl;
+
+        return false;
+    }
+
+    file << "P6\n" << screenWidth << " " << screenHeight << "\n255\n";
+
+    // GL rows start at the bottom, PPM rows at the top.
+    for (int y = screenHeight - 1; y >= 0; y--)
+    {
+        for (int x = 0; x < screenWidth; x++)
+        {
+            file.write((char*)&pixels[(y * screenWidth + x) * 4], 3);
+        }
+    }
+
+    return true;
+}
+
+void shutdownScreen()
+{
+    if (headless == true && captureFilename.empty() == false)
+    {
+        captureFrame(captureFilename);
+    }
+
+    if (screenFrameBufferId != 0)
+    {
+        glDeleteFramebuffers(1, &screenFrameBufferId);
+        glDeleteRenderbuffers(1, &screenColorBufferId);
+        glDeleteRenderbuffers(1, &screenDepthBufferId);
+
+        screenFrameBufferId = 0;
+        screenColorBufferId = 0;
+        screenDepthBufferId = 0;
+    }
+
+#if defined(TESTBED_HEADLESS_EGL)
+    if (eglDisplay != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        if (eglContext != EGL_NO_CONTEXT)
+        {
+            eglDestroyContext(eglDisplay, eglContext);
+        }
+
+        eglTerminate(eglDisplay);
+
+        eglDisplay = EGL_NO_DISPLAY;
+        eglContext = EGL_NO_CONTEXT;
+    }
+#elif defined(TESTBED_HEADLESS_OSMESA)
+    if (osMesaContext != NULL)
+    {
+        OSMesaDestroyContext(osMesaContext);
+
+        osMesaContext = NULL;
+    }
+#endif
+
+    if (window != NULL)
+    {
+        SDL_DestroyWindow(window);
+
+        window = NULL;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+
+#include <GL/glew.h>
+
+#include "SDL.h"
+
+extern SDL_Window*     window;
+extern SDL_Surface*    screen;
+extern SDL_Renderer*   sdlRenderer;
+extern SDL_GLContext   openGlContext;
+
+extern int             screenWidth;
+extern int             screenHeight;
+
+// When set, initializeScreen() creates a windowless core profile context
+// (EGL surfaceless or OSMesa) and renders into an offscreen FBO.
+extern bool            headless;
+
+// Number of frames to render before quitting. Zero runs until the window is closed.
+extern int             frameLimit;
+
+// If not empty, the last headless frame is written to this file as a PPM.
+extern std::string     captureFilename;
+
+// The framebuffer standing in for the window. Zero when rendering to a
+// window, the offscreen FBO when headless.
+extern GLuint          screenFrameBufferId;
+
+// Reads --headless, --frames <n> and --capture <file> from the command line.
+void parseScreenArgs(int argc, char* argv[]);
+
+bool initializeScreen();
+
+// Drain the SDL event queue. Returns true if the window was asked to close.
+bool pollQuitEvent();
+
+// Swap the window, or finish the frame when headless.
+void presentFrame();
+
+// Make the context current on the calling thread, once the thread that had it
+// released it. Swapping is then that thread's job too.
+bool makeContextCurrent();
+
+void releaseContext();
+
+bool captureFrame(std::string filename);
+
+void shutdownScreen();
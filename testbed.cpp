@@ -0,0 +1,2438 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <GL/glu.h>
+
+#include <IL/il.h>
+#include <IL/ilu.h>
+
+#include "asset_pack.h"
+#include "baked_texture.h"
+#include "camera.h"
+#include "content_hash.h"
+#include "frame_arena.h"
+#include "gpu_buffer_arena.h"
+#include "job_system.h"
+#include "mipmaps.h"
+#include "profiler.h"
+#include "quad_groups.h"
+#include "quad_store.h"
+#include "quad_transform.h"
+#include "screen.h"
+#include "testbed.h"
+
+glm::mat4       projectionMatrix;
+glm::mat4       modelViewMatrix;
+
+// Start at full red for groups.
+ColorRgba       groupColor { 1.0f, 0.0f, 0.0f, 1.0f };
+
+// groupColor as RGBA8, for the instances and compact vertices.
+static GLubyte  groupColorBytes[4] = { 255, 0, 0, 255 };
+
+// The color of group 0, as set by the last resetGroupColor().
+static ColorRgba baseGroupColor { 1.0f, 0.0f, 0.0f, 1.0f };
+static GLubyte  baseGroupColorBytes[4] = { 255, 0, 0, 255 };
+
+uint32_t        colorCounter = 0;
+
+const std::vector<QuadParams>* benchmarkScene = NULL;
+
+Shader*         benchmarkSceneShader = NULL;
+
+UploadStats     uploadStats = { 0, 0, 0.0, 0, 0 };
+
+bool            viewportCulling = false;
+
+CullStats       cullStats = { 0, 0 };
+
+UploadMode      uploadMode = UPLOAD_SUB_DATA;
+
+bool            skipUnchangedUploads = true;
+
+bool            instancedQuads = false;
+
+bool            retainedQuads = false;
+
+VertexFormat    vertexFormat = VERTEX_FORMAT_FLOAT;
+
+// Tex coords of each corner addQuad() emits, as 0 or 1.
+static const int quadCornerTexCoords[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+// 1.0 as a half float.
+static const GLhalf halfFloatOne = 0x3C00;
+
+// Corners of the unit quad the instanced renderer expands, in the order addQuad() emits them.
+static const GLfloat unitQuadCorners[8] = { -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f };
+
+// The static index buffer every shader draws its quads from: two triangles, 0 1 2
+// and 0 2 3, per quad, for quadIndexCapacity quads. Created by the first
+// initShader() and deleted when the last shader using it is freed.
+static GLuint   quadIndexBufferId = 0;
+static int      quadIndexCapacity = 0;
+static int      quadIndexUsers = 0;
+
+// Declares what the expanded vertices would have held, computed from the
+// instance, in place of the vertex shader's own vertexPos3D, tex_coords_in and
+// color_in inputs.
+static const char* instancedQuadShaderCode = R"V0G0N(
+// Per vertex: a corner of the unit quad.
+in vec2 quadCorner;
+
+// Per instance.
+in vec2 instanceCenter;
+in vec2 instanceHalfSize;
+in float instanceRotation;
+in float instanceScale;
+in vec4 instanceColor;
+
+vec3 vertexPos3D;
+vec2 tex_coords_in;
+vec4 color_in;
+
+void expandQuadCorner()
+{
+    vec2 offset = quadCorner * instanceHalfSize * instanceScale;
+
+    float sinTheta = sin(instanceRotation);
+    float cosTheta = cos(instanceRotation);
+
+    vertexPos3D = vec3(instanceCenter.x + offset.x * cosTheta - offset.y * sinTheta,
+                       instanceCenter.y + offset.x * sinTheta + offset.y * cosTheta,
+                       0.0);
+
+    tex_coords_in = quadCorner * 0.5 + 0.5;
+
+    color_in = instanceColor;
+}
+)V0G0N";
+
+uint32_t getGroupColor(uint32_t counter)
+{
+    // Determine which component or components will be used.
+    // 7 combinations, not 8, because using no components doesn't make sense.
+
+    // R     | 1 0 0   4
+    //   G   | 0 1 0   2
+    //     B | 0 0 1   1
+    // R G   | 1 1 0   6
+    // R   B | 1 0 1   5
+    //   G B | 0 1 1   3
+    // R G B | 1 1 1   7
+
+    int components = (counter % 7) + 1;
+
+    // Get the component bit, and shift it into bit position 0, then do a lshift to shift it into bit position 8.
+    // After that cast to a signed char and shift right by 7 to do an arithmetic shift back into position 0, filling
+    // all bits with the least significant bit. Then, recast it back to an unsigned 8 bit int to remove the leading 1's
+    // that get added in a two's compliment represenation of signed integers, and concatenate it onto the component mask
+    // by casting it back to a unsigned 32 bit int. Bitwise and the components mask with the component value, which is a
+    // counter that counts by increments of ((256 / 8) + 1), ((256 / 4) + 1), and ((256 / 2) + 1), and will overflow
+    // because they are stored in a uint8_t. This is so that the different color component values don't increment at
+    // the same strides.  Also, they will count down from 255, so that the first color isn't full black.
+
+    uint32_t blue  = ((uint32_t)((uint8_t)((int8_t)( (components & 0x1) << 7) >> 7)       & (255 - (uint8_t)(counter * 33)))  << 8 );
+    uint32_t green = ((uint32_t)((uint8_t)((int8_t)(((components & 0x2) >> 1) << 7) >> 7) & (255 - (uint8_t)(counter * 65)))  << 16);
+    uint32_t red   = ((uint32_t)((uint8_t)((int8_t)(((components & 0x4) >> 2) << 7) >> 7) & (255 - (uint8_t)(counter * 129))) << 24);
+
+    // Always use full alpha channel.
+    uint32_t finalColor = red | green | blue | 0x000000FF;
+
+    return finalColor;
+};
+
+void resetGroupColor(ColorRgba color)
+{
+    colorCounter = 0;
+
+    groupColor = color;
+
+    groupColorBytes[0] = color.r * 255.0f + 0.5f;
+    groupColorBytes[1] = color.g * 255.0f + 0.5f;
+    groupColorBytes[2] = color.b * 255.0f + 0.5f;
+    groupColorBytes[3] = color.a * 255.0f + 0.5f;
+
+    baseGroupColor = color;
+
+    memcpy(baseGroupColorBytes, groupColorBytes, 4);
+}
+
+void rotatePoints(float rotationAngle, const std::vector<Vertex2>& pointsToRotate, std::vector<Vertex2>& rotatedPoints, Vertex2 originTranslation)
+{
+    // Convert degrees to radians and set the cos and sin values for rotation.
+    double pi = 3.1415926535897;
+
+    // The point after being translated to the native origin.
+    Vertex2 translatedToScreenOrigin;
+
+    // The point after being rotated about the origin.
+    Vertex2 rotatedPoint;
+
+    float radians = (rotationAngle * pi) / 180.0;
+
+    float sinTheta = sin(radians);
+
+    float cosTheta = cos(radians);
+
+    for (size_t i = 0; i < pointsToRotate.size(); i++)
+    {
+        // STEP 1: Translate each value to origin.
+        translatedToScreenOrigin.x = pointsToRotate[i].x;
+        translatedToScreenOrigin.y = pointsToRotate[i].y;
+
+        translatedToScreenOrigin.x -= originTranslation.x;
+        translatedToScreenOrigin.y -= originTranslation.y;
+
+        // STEP 2: Do the actual rotation transform about the native origin.
+        rotatedPoint.x = (translatedToScreenOrigin.x * cosTheta) - (translatedToScreenOrigin.y * sinTheta);
+        rotatedPoint.y = (translatedToScreenOrigin.x * sinTheta) + (translatedToScreenOrigin.y * cosTheta);
+
+        // STEP 3: Translate the vertices back to original position.
+        rotatedPoint.x += originTranslation.x;
+        rotatedPoint.y += originTranslation.y;
+
+        // STEP 4: Set the rotated values into the corners objects.
+        rotatedPoints[i].x = rotatedPoint.x;
+        rotatedPoints[i].y = rotatedPoint.y;
+    }
+}
+
+// Color of group groupIndex: the resetGroupColor() color for group 0, then
+// getGroupColor(groupIndex) keeping the reset color's alpha. It only depends on
+// the index, so quads can be built in any order.
+static void getGroupColorForIndex(uint32_t groupIndex, ColorRgba& color, GLubyte bytes[4])
+{
+    color = baseGroupColor;
+
+    memcpy(bytes, baseGroupColorBytes, 4);
+
+    if (groupIndex == 0)
+    {
+        return;
+    }
+
+    uint32_t packedColor = getGroupColor(groupIndex);
+
+    color.r = ((packedColor & 0xFF000000) >> 24) / 255.0f;
+    color.g = ((packedColor & 0x00FF0000) >> 16) / 255.0f;
+    color.b = ((packedColor & 0x0000FF00) >> 8)  / 255.0f;
+
+    bytes[0] = (packedColor & 0xFF000000) >> 24;
+    bytes[1] = (packedColor & 0x00FF0000) >> 16;
+    bytes[2] = (packedColor & 0x0000FF00) >> 8;
+}
+
+static void selectGroupColor(bool newGroup)
+{
+    // Pick a new color for the new quad group.
+    if (newGroup == true)
+    {
+        colorCounter++;
+
+        getGroupColorForIndex(colorCounter, groupColor, groupColorBytes);
+    }
+}
+
+// What the culling keeps quads overlapping: the world the camera shows.
+static CullRect viewportCullRect()
+{
+    return getCameraCullRect();
+}
+
+// Whether the culling drops a quad halfWidth * scale by halfHeight * scale
+// world units each side of (centerX, centerY), and count it either way.
+static bool quadCulled(float centerX, float centerY, float halfWidth, float halfHeight, float rotationDegrees, float scale)
+{
+    if (viewportCulling == false)
+    {
+        return false;
+    }
+
+    uint8_t visible;
+
+    cullQuads(&centerX, &centerY, &rotationDegrees, &scale, 1, halfWidth, halfHeight, viewportCullRect(), &visible);
+
+    cullStats.visibleQuads += visible;
+    cullStats.culledQuads += 1 - visible;
+
+    return visible == 0;
+}
+
+static void writeQuadInstance(QuadInstance& instance, float centerX, float centerY, int halfWidth, int halfHeight, float rotationDegrees, float scale, const GLubyte color[4])
+{
+    instance.centerX = centerX;
+    instance.centerY = centerY;
+
+    instance.halfWidth = halfWidth;
+    instance.halfHeight = halfHeight;
+
+    instance.rotation = (rotationDegrees * 3.1415926535897) / 180.0;
+    instance.scale = scale;
+
+    instance.color[0] = color[0];
+    instance.color[1] = color[1];
+    instance.color[2] = color[2];
+    instance.color[3] = 255;
+}
+
+static void addQuadInstance(Shader& shader, float centerX, float centerY, int halfWidth, int halfHeight, float rotationDegrees, float scale)
+{
+    QuadInstance instance;
+
+    writeQuadInstance(instance, centerX, centerY, halfWidth, halfHeight, rotationDegrees, scale, groupColorBytes);
+
+    shader.instanceData.push_back(instance);
+
+    markQuadsDirty(shader, shader.instanceData.size() - 1, 1);
+}
+
+static void writeCompactQuad(CompactVertex* vertices, const Vertex2* corners, const GLubyte color[4])
+{
+    for (int i = 0; i < 4; i++)
+    {
+        CompactVertex& vertex = vertices[i];
+
+        vertex.x = corners[i].x;
+        vertex.y = corners[i].y;
+
+        vertex.s = quadCornerTexCoords[i][0] ? halfFloatOne : 0;
+        vertex.t = quadCornerTexCoords[i][1] ? halfFloatOne : 0;
+
+        memcpy(vertex.color, color, 4);
+    }
+}
+
+static void writePackedQuad(PackedVertex* vertices, const Vertex2* corners, const GLubyte color[4])
+{
+    for (int i = 0; i < 4; i++)
+    {
+        PackedVertex& vertex = vertices[i];
+
+        // Round to the nearest pixel. Out of range, the conversion to short is undefined.
+        vertex.x = floorf(std::min(packedVertexLimit, std::max(-packedVertexLimit, corners[i].x)) + 0.5f);
+        vertex.y = floorf(std::min(packedVertexLimit, std::max(-packedVertexLimit, corners[i].y)) + 0.5f);
+
+        vertex.s = quadCornerTexCoords[i][0] ? 0xFFFF : 0;
+        vertex.t = quadCornerTexCoords[i][1] ? 0xFFFF : 0;
+
+        memcpy(vertex.color, color, 4);
+    }
+}
+
+static void writeFloatQuad(VertexData3D* vData, const Vertex2* transformedCorners, const ColorRgba& color)
+{
+    // Position
+    vData[0].pos.x = transformedCorners[0].x;
+    vData[0].pos.y = transformedCorners[0].y;
+    vData[0].pos.z = 0.0f;
+
+    vData[1].pos.x = transformedCorners[1].x;
+    vData[1].pos.y = transformedCorners[1].y;
+    vData[1].pos.z = 0.0f;
+
+    vData[2].pos.x = transformedCorners[2].x;
+    vData[2].pos.y = transformedCorners[2].y;
+    vData[2].pos.z = 0.0f;
+
+    vData[3].pos.x = transformedCorners[3].x;
+    vData[3].pos.y = transformedCorners[3].y;
+    vData[3].pos.z = 0.0f;
+
+    vData[0].texCoords.s = 0.0;
+    vData[0].texCoords.t = 0.0;
+
+    vData[1].texCoords.s = 1.0;
+    vData[1].texCoords.t = 0.0;
+
+    vData[2].texCoords.s = 1.0;
+    vData[2].texCoords.t = 1.0;
+
+    vData[3].texCoords.s = 0.0;
+    vData[3].texCoords.t = 1.0;
+
+    vData[0].color.r = color.r;
+    vData[0].color.g = color.g;
+    vData[0].color.b = color.b;
+    vData[0].color.a = 1.0;
+
+    vData[1].color.r = color.r;
+    vData[1].color.g = color.g;
+    vData[1].color.b = color.b;
+    vData[1].color.a = 1.0;
+
+    vData[2].color.r = color.r;
+    vData[2].color.g = color.g;
+    vData[2].color.b = color.b;
+    vData[2].color.a = 1.0;
+
+    vData[3].color.r = color.r;
+    vData[3].color.g = color.g;
+    vData[3].color.b = color.b;
+    vData[3].color.a = 1.0;
+}
+
+// Write quad quadIndex's four vertices in the selected vertex format. The
+// staging vector must already hold them.
+static void writeQuadVertices(Shader& shader, int quadIndex, const Vertex2* corners, const ColorRgba& color, const GLubyte colorBytes[4])
+{
+    switch (vertexFormat)
+    {
+    case VERTEX_FORMAT_COMPACT:
+        writeCompactQuad(&shader.compactVertexData[4 * quadIndex], corners, colorBytes);
+        break;
+
+    case VERTEX_FORMAT_PACKED:
+        writePackedQuad(&shader.packedVertexData[4 * quadIndex], corners, colorBytes);
+        break;
+
+    default:
+        writeFloatQuad(&shader.vertexData[4 * quadIndex], corners, color);
+        break;
+    }
+}
+
+// The vectors don't initialize new elements and clearQuads() keeps their
+// capacity, so after the first frame this is only a size change.
+void resizeQuads(Shader& shader, int quadCount)
+{
+    if (instancedQuads == true)
+    {
+        shader.instanceData.resize(quadCount);
+
+        return;
+    }
+
+    switch (vertexFormat)
+    {
+    case VERTEX_FORMAT_COMPACT:
+        shader.compactVertexData.resize(4 * quadCount);
+        break;
+
+    case VERTEX_FORMAT_PACKED:
+        shader.packedVertexData.resize(4 * quadCount);
+        break;
+
+    default:
+        shader.vertexData.resize(4 * quadCount);
+        break;
+    }
+}
+
+// Write quad quadIndex, in either mode, and mark it dirty.
+static void writeQuadAt(Shader& shader, int quadIndex, float x, float y, float w, float h, float rotationDegrees, const ColorRgba& color, const GLubyte colorBytes[4])
+{
+    int quadHalfWidth = w / 2;
+
+    int quadHalfHeight = h / 2;
+
+    if (instancedQuads == true)
+    {
+        writeQuadInstance(shader.instanceData[quadIndex], x, y, quadHalfWidth, quadHalfHeight, rotationDegrees, 1.0f, colorBytes);
+    }
+    else
+    {
+        // A batch of one, so these quads come out of the same kernel as addScene()'s.
+        float centerX = x;
+        float centerY = y;
+        float scale = 1.0f;
+
+        Vertex2 transformedCorners[4];
+
+        transformQuadCorners(&centerX, &centerY, &rotationDegrees, &scale, 1, quadHalfWidth, quadHalfHeight, transformedCorners);
+
+        writeQuadVertices(shader, quadIndex, transformedCorners, color, colorBytes);
+    }
+
+    markQuadsDirty(shader, quadIndex, 1);
+}
+
+void addQuad(Shader& shader, float x, float y, float w, float h, float rotationDegrees, bool newGroup)
+{
+    selectGroupColor(newGroup);
+
+    int quadIndex = getQuadCount(shader);
+
+    addQuadGroupStart(shader, quadIndex, newGroup);
+
+    if (quadCulled(x, y, (int)(w / 2), (int)(h / 2), rotationDegrees, 1.0f) == true)
+    {
+        return;
+    }
+
+    resizeQuads(shader, quadIndex + 1);
+
+    writeQuadAt(shader, quadIndex, x, y, w, h, rotationDegrees, groupColor, groupColorBytes);
+}
+
+void writeQuad(Shader& shader, int quadIndex, float x, float y, float w, float h, float rotationDegrees, ColorRgba color)
+{
+    GLubyte colorBytes[4];
+
+    colorBytes[0] = color.r * 255.0f + 0.5f;
+    colorBytes[1] = color.g * 255.0f + 0.5f;
+    colorBytes[2] = color.b * 255.0f + 0.5f;
+    colorBytes[3] = color.a * 255.0f + 0.5f;
+
+    writeQuadAt(shader, quadIndex, x, y, w, h, rotationDegrees, color, colorBytes);
+}
+
+void moveQuad(Shader& shader, int from, int to)
+{
+    if (instancedQuads == true)
+    {
+        shader.instanceData[to] = shader.instanceData[from];
+    }
+    else
+    {
+        switch (vertexFormat)
+        {
+        case VERTEX_FORMAT_COMPACT:
+            std::copy_n(&shader.compactVertexData[4 * from], 4, &shader.compactVertexData[4 * to]);
+            break;
+
+        case VERTEX_FORMAT_PACKED:
+            std::copy_n(&shader.packedVertexData[4 * from], 4, &shader.packedVertexData[4 * to]);
+            break;
+
+        default:
+            std::copy_n(&shader.vertexData[4 * from], 4, &shader.vertexData[4 * to]);
+            break;
+        }
+    }
+
+    markQuadsDirty(shader, to, 1);
+}
+
+void addSquareQuad(Shader& shader, float x, float y, float rotationDegrees, float scale, bool newGroup)
+{
+    if (scale <= 0.0f) {
+        scale = 1.0f;
+    }
+
+    if (instancedQuads == true)
+    {
+        selectGroupColor(newGroup);
+
+        addQuadGroupStart(shader, getQuadCount(shader), newGroup);
+
+        if (quadCulled(x, y, 25, 25, rotationDegrees, scale) == true)
+        {
+            return;
+        }
+
+        // The shader applies the scale, so the instance keeps the unscaled half size.
+        addQuadInstance(shader, x, y, 25, 25, rotationDegrees, scale);
+
+        return;
+    }
+
+    int quadSize = 50 * scale;
+
+    addQuad(shader, x, y, quadSize, quadSize, rotationDegrees, newGroup);
+}
+
+// Quads per block of addScene(). Blocks are the unit handed to the worker
+// threads, and a block's transform scratch fits on the stack.
+const int sceneBlockQuads = 512;
+
+// The kernels' parameters for a quad addSquareQuad() would add: its center in
+// world units, and its scale for a half size of sceneQuadHalfSize(). Instances keep
+// the scale their shader applies. Vertices are sized in whole pixels, so their
+// scale carries the rounded half size and the half size is 1.
+static void getSceneQuadParams(const QuadParams& quad, float& centerX, float& centerY, float& scale)
+{
+    float quadScale = (quad.scale <= 0.0f) ? 1.0f : quad.scale;
+
+    centerX = quad.x;
+    centerY = quad.y;
+
+    scale = instancedQuads ? quadScale : (int)(50 * quadScale) / 2;
+}
+
+static float sceneQuadHalfSize()
+{
+    return instancedQuads ? 25.0f : 1.0f;
+}
+
+// Cull quads [begin, end) of the scene, one block, into visible[begin] on.
+// Returns how many are visible.
+static int cullSceneBlock(const QuadParams* quads, int begin, int end, uint8_t* visible)
+{
+    float centerX[sceneBlockQuads];
+    float centerY[sceneBlockQuads];
+    float rotationDegrees[sceneBlockQuads];
+    float scale[sceneBlockQuads];
+
+    int count = end - begin;
+
+    for (int i = 0; i < count; i++)
+    {
+        getSceneQuadParams(quads[begin + i], centerX[i], centerY[i], scale[i]);
+
+        rotationDegrees[i] = quads[begin + i].rotationDegrees;
+    }
+
+    float halfSize = sceneQuadHalfSize();
+
+    return cullQuads(centerX, centerY, rotationDegrees, scale, count, halfSize, halfSize, viewportCullRect(), visible + begin);
+}
+
+// Build quads [begin, end) of the scene, one block, into the staging vector
+// from firstQuad on, leaving out those visible marks culled when it isn't
+// NULL. firstGroup is the group index the quad before begin was in, and the
+// quad indices of the groups the block starts go to groupStarts.
+static void buildSceneBlock(Shader& shader, const QuadParams* quads, int begin, int end, const uint8_t* visible, int firstQuad, uint32_t firstGroup, int* groupStarts)
+{
+    float centerX[sceneBlockQuads];
+    float centerY[sceneBlockQuads];
+    float rotationDegrees[sceneBlockQuads];
+    float scale[sceneBlockQuads];
+
+    // Group of each quad kept.
+    uint32_t groups[sceneBlockQuads];
+
+    uint32_t groupIndex = firstGroup;
+
+    int count = 0;
+
+    for (int i = begin; i < end; i++)
+    {
+        // A group starts at the next quad kept, even if its first ones are culled.
+        if (quads[i].newGroup == true)
+        {
+            groupIndex++;
+
+            *groupStarts++ = firstQuad + count;
+        }
+
+        if (visible != NULL && visible[i] == 0)
+        {
+            continue;
+        }
+
+        getSceneQuadParams(quads[i], centerX[count], centerY[count], scale[count]);
+
+        rotationDegrees[count] = quads[i].rotationDegrees;
+        groups[count] = groupIndex;
+
+        count++;
+    }
+
+    uint32_t colorGroup = firstGroup;
+
+    ColorRgba color;
+    GLubyte colorBytes[4];
+
+    getGroupColorForIndex(colorGroup, color, colorBytes);
+
+    if (instancedQuads == true)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (groups[i] != colorGroup)
+            {
+                colorGroup = groups[i];
+
+                getGroupColorForIndex(colorGroup, color, colorBytes);
+            }
+
+            writeQuadInstance(shader.instanceData[firstQuad + i], centerX[i], centerY[i], 25, 25, rotationDegrees[i], scale[i], colorBytes);
+        }
+
+        return;
+    }
+
+    Vertex2 corners[4 * sceneBlockQuads];
+
+    transformQuadCorners(centerX, centerY, rotationDegrees, scale, count, 1.0f, 1.0f, corners);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (groups[i] != colorGroup)
+        {
+            colorGroup = groups[i];
+
+            getGroupColorForIndex(colorGroup, color, colorBytes);
+        }
+
+        writeQuadVertices(shader, firstQuad + i, &corners[4 * i], color, colorBytes);
+    }
+}
+
+void addScene(Shader& shader, const std::vector<QuadParams>& quads)
+{
+    // Same colors every frame, whatever the previous scene left behind.
+    resetGroupColor(ColorRgba{ 1.0f, 0.0f, 0.0f, 1.0f });
+
+    int quadCount = quads.size();
+
+    if (quadCount == 0)
+    {
+        return;
+    }
+
+    int firstQuad = getQuadCount(shader);
+
+    int blockCount = (quadCount + sceneBlockQuads - 1) / sceneBlockQuads;
+
+    // A quad's color is a function of how many groups started before it, and
+    // its slot of how many quads before it were kept. Count the new groups and
+    // the visible quads in each block, then add them up so each block knows
+    // the group it starts in and where its quads go, then build.
+    uint32_t* blockGroups = frameArenaAllocateArray<uint32_t>(blockCount);
+    int* blockQuads = frameArenaAllocateArray<int>(blockCount);
+
+    uint8_t* visible = (viewportCulling == true) ? frameArenaAllocateArray<uint8_t>(quadCount) : NULL;
+
+    uint32_t groupCount = 0;
+
+    int keptCount = 0;
+
+    // Group 0 starts at quad 0, as addQuad() would have made it.
+    addQuadGroupStart(shader, firstQuad, false);
+
+    size_t firstGroupStart = shader.groupStarts.size();
+
+    auto countBlocks = [&](int beginBlock, int endBlock)
+    {
+        for (int block = beginBlock; block < endBlock; block++)
+        {
+            int begin = block * sceneBlockQuads;
+            int end = std::min(quadCount, begin + sceneBlockQuads);
+
+            uint32_t newGroups = 0;
+
+            for (int i = begin; i < end; i++)
+            {
+                newGroups += quads[i].newGroup ? 1 : 0;
+            }
+
+            blockGroups[block] = newGroups;
+            blockQuads[block] = (visible != NULL) ? cullSceneBlock(quads.data(), begin, end, visible) : end - begin;
+        }
+    };
+
+    auto sumBlocks = [&]()
+    {
+        for (int block = 0; block < blockCount; block++)
+        {
+            uint32_t newGroups = blockGroups[block];
+            int blockKept = blockQuads[block];
+
+            blockGroups[block] = groupCount;
+            blockQuads[block] = keptCount;
+
+            groupCount += newGroups;
+            keptCount += blockKept;
+        }
+
+        resizeQuads(shader, firstQuad + keptCount);
+
+        // Each block writes the starts of the groups it begins into its own slots.
+        shader.groupStarts.resize(firstGroupStart + groupCount);
+    };
+
+    auto buildBlocks = [&](int beginBlock, int endBlock)
+    {
+        for (int block = beginBlock; block < endBlock; block++)
+        {
+            int begin = block * sceneBlockQuads;
+            int end = std::min(quadCount, begin + sceneBlockQuads);
+
+            int* groupStarts = shader.groupStarts.data() + firstGroupStart + blockGroups[block];
+
+            buildSceneBlock(shader, quads.data(), begin, end, visible, firstQuad + blockQuads[block], blockGroups[block], groupStarts);
+        }
+    };
+
+    Job* counting = createParallelForJob(blockCount, (visible != NULL) ? 4 : 16, countBlocks);
+    Job* summing = createJob(sumBlocks);
+    Job* building = createParallelForJob(blockCount, 1, buildBlocks);
+
+    jobDependsOn(summing, counting);
+    jobDependsOn(building, summing);
+
+    runJob(building);
+    runJob(summing);
+    runJob(counting);
+
+    waitForJob(building);
+
+    markQuadsDirty(shader, firstQuad, keptCount);
+
+    if (visible != NULL)
+    {
+        cullStats.visibleQuads += keptCount;
+        cullStats.culledQuads += quadCount - keptCount;
+    }
+
+    // Leave the color state where adding the quads one by one would have.
+    colorCounter = groupCount;
+
+    getGroupColorForIndex(groupCount, groupColor, groupColorBytes);
+}
+
+int getQuadCount(const Shader& shader)
+{
+    if (instancedQuads == true)
+    {
+        return shader.instanceData.size();
+    }
+
+    switch (vertexFormat)
+    {
+    case VERTEX_FORMAT_COMPACT:
+        return shader.compactVertexData.size() / 4;
+
+    case VERTEX_FORMAT_PACKED:
+        return shader.packedVertexData.size() / 4;
+
+    default:
+        return shader.vertexData.size() / 4;
+    }
+}
+
+void clearQuads(Shader& shader)
+{
+    shader.vertexData.clear();
+    shader.compactVertexData.clear();
+    shader.packedVertexData.clear();
+    shader.instanceData.clear();
+
+    // A retained shader starts over: what gets added next is uploaded whole.
+    clearDirtyQuads(shader);
+
+    shader.uploadedQuadCount = 0;
+
+    shader.groupStarts.clear();
+}
+
+bool loadBufferIntoTexture(GLint* buffer, size_t size, int width, int height, GLuint& textureId)
+{
+    // Generate texture ID
+    glGenTextures(1, &textureId);
+
+    RETURN_IF_GL_ERROR("glGenTextures");
+
+    // Bind texture ID
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindTexture(GL_TEXTURE_RECTANGLE, textureId);
+
+    glTexImage2D(
+        GL_TEXTURE_RECTANGLE,
+        0,
+        GL_RGBA32I,
+        width,
+        height,
+        0,
+        GL_RGBA_INTEGER,
+        GL_INT,
+        (GLuint*)buffer);
+
+    RETURN_IF_GL_ERROR("glTexImage2D");
+
+    //Set texture parameters
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+    //Unbind texture
+    glBindTexture(GL_TEXTURE_RECTANGLE, 0);
+
+    return true;
+}
+
+// Held around DevIL decodes, which share the bound image.
+static std::mutex imageLoaderMutex;
+
+bool initImageLoader()
+{
+    ilInit();
+    iluInit();
+
+    ILenum error = ilGetError();
+
+    if (error != IL_NO_ERROR)
+    {
+        std::cout << "Error initializing DevIL: " << iluErrorString(error) << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool decodeImageFile(std::string filename, DecodedImage& image, uint64_t* fileHash)
+{
+    image.width = 0;
+    image.height = 0;
+    image.levelCount = 1;
+    image.pixels.clear();
+
+    // Decoded straight from the asset pack's mapping when it has the file.
+    std::vector<unsigned char> imageBuffer;
+
+    AssetSpan imageSpan;
+
+    if (readAsset(filename, imageBuffer, imageSpan) == false)
+    {
+        std::cout << "Failed to open image file " << filename << std::endl;
+
+        return false;
+    }
+
+    if (fileHash != NULL)
+    {
+        *fileHash = hashBytes(imageSpan.data, imageSpan.bytes);
+    }
+
+    // DevIL decodes into the one image bound for the whole process.
+    std::lock_guard<std::mutex> lock(imageLoaderMutex);
+
+    // Generate and set current image ID
+    ILuint imgID = 0;
+    ilGenImages(1, &imgID);
+    ilBindImage(imgID);
+
+    bool ret = true;
+
+    ILboolean success = ilLoadL(IL_PNG, imageSpan.data, imageSpan.bytes);
+
+    //Image loaded successfully
+    if (success == IL_TRUE)
+    {
+        //Convert image to RGBA
+        success = ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE);
+
+        if (success == IL_TRUE)
+        {
+            ILinfo imageInfo;
+
+            iluGetImageInfo(&imageInfo);
+
+            const unsigned char* data = (const unsigned char*)imageInfo.Data;
+
+            image.width = imageInfo.Width;
+            image.height = imageInfo.Height;
+            image.pixels.assign(data, data + (size_t)imageInfo.Width * imageInfo.Height * 4);
+        }
+        else
+        {
+            ILenum error = ilGetError();
+
+            std::cout << "Failed to convert image pixels to RGBA format: " << iluErrorString(error) << std::endl;
+
+            ret = false;
+        }
+    }
+    else
+    {
+        ILenum error = ilGetError();
+
+        std::cout << "Failed to load sprite sheet image: " << iluErrorString(error) << std::endl;
+
+        ret = false;
+    }
+
+    ilDeleteImage(imgID);
+
+    return ret;
+}
+
+void setImageTextureParameters(int levelCount)
+{
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (levelCount > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+}
+
+bool loadImageIntoTexture(std::string filename, GLuint& textureId, uint32_t level, LoadedTextureInfo* info)
+{
+    // A baked copy the GL can't take, compressed in a format it lacks, falls back to the image.
+    if (bakedTextureAvailable(filename) == true && loadBakedTexture(getBakedTexturePath(filename), textureId, level, info) == true)
+    {
+        return true;
+    }
+
+    DecodedImage image;
+
+    if (decodeImageFile(filename, image, (info != NULL) ? &info->fileHash : NULL) == false)
+    {
+        return false;
+    }
+
+    if (textureMipmaps == true)
+    {
+        generateMipmaps(image, true);
+    }
+
+    // Generate texture ID
+    glGenTextures(1, &textureId);
+
+    //Check for error
+    GLenum error = glGetError();
+
+    if (error != GL_NO_ERROR)
+    {
+        std::cout << "glGenTextures failed with error: " << gluErrorString(error) << std::endl;
+
+        return false;
+    }
+
+    // Bind texture ID
+    glActiveTexture(GL_TEXTURE0 + level);
+
+    glBindTexture(GL_TEXTURE_2D, textureId);
+
+    for (int i = 0; i < image.levelCount; i++)
+    {
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            i,
+            GL_RGBA,
+            getMipLevelSize(image.width, i),
+            getMipLevelSize(image.height, i),
+            0,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            image.pixels.data() + getMipLevelOffset(image.width, image.height, i));
+    }
+
+    //Set texture parameters
+    setImageTextureParameters(image.levelCount);
+
+    //Unbind texture
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    //Check for error
+    error = glGetError();
+
+    if (error != GL_NO_ERROR)
+    {
+        std::cout << "Error loading texture from byte array: " << gluErrorString(error) << std::endl;
+
+        return false;
+    }
+
+    if (info != NULL)
+    {
+        info->bytes = image.pixels.size();
+    }
+
+    return true;
+}
+
+GLuint createShaders(std::string vertexShaderCode, std::string fragmentShaderCode)
+{
+    // Create the shaders
+    GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
+    GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
+
+    GLint Result = GL_FALSE;
+    int InfoLogLength;
+
+    // Compile Vertex Shader
+    char const* vertexSourcePointer = vertexShaderCode.c_str();
+    glShaderSource(vertexShaderId, 1, &vertexSourcePointer, NULL);
+    glCompileShader(vertexShaderId);
+
+    // Check Vertex Shader
+    glGetShaderiv(vertexShaderId, GL_COMPILE_STATUS, &Result);
+
+    glGetShaderiv(vertexShaderId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+
+    if (InfoLogLength > 0)
+    {
+        std::vector<char> vertexShaderErrorMessage(InfoLogLength);
+
+        glGetShaderInfoLog(vertexShaderId, InfoLogLength, NULL, &vertexShaderErrorMessage[0]);
+
+        std::cout << &vertexShaderErrorMessage[0] << std::endl;
+    }
+
+    // Compile Fragment Shader
+    char const* fragmentSourcePointer = fragmentShaderCode.c_str();
+    glShaderSource(fragmentShaderId, 1, &fragmentSourcePointer, NULL);
+    glCompileShader(fragmentShaderId);
+
+    // Check Fragment Shader
+    glGetShaderiv(fragmentShaderId, GL_COMPILE_STATUS, &Result);
+    glGetShaderiv(fragmentShaderId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+
+    if (InfoLogLength > 0)
+    {
+        std::vector<char> fragmentShaderErrorMessage(InfoLogLength);
+        glGetShaderInfoLog(fragmentShaderId, InfoLogLength, NULL, &fragmentShaderErrorMessage[0]);
+        std::cout << &fragmentShaderErrorMessage[0] << std::endl;
+    }
+
+    // Link
+    GLuint programId = glCreateProgram();
+    glAttachShader(programId, vertexShaderId);
+    glAttachShader(programId, fragmentShaderId);
+    glLinkProgram(programId);
+
+    // Check the program
+    glGetProgramiv(programId, GL_LINK_STATUS, &Result);
+    glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &InfoLogLength);
+
+    if (InfoLogLength > 0)
+    {
+        std::vector<char> programErrorMessage(std::max(InfoLogLength, int(1)));
+        glGetProgramInfoLog(programId, InfoLogLength, NULL, &programErrorMessage[0]);
+        std::cout << &programErrorMessage[0] << std::endl;
+    }
+
+    glDeleteShader(vertexShaderId);
+    glDeleteShader(fragmentShaderId);
+
+    return programId;
+}
+
+bool initFbo(GLuint& frameBufferId, GLuint& colorTextureId)
+{
+
+    glGenFramebuffers(1, &frameBufferId);
+
+    RETURN_IF_GL_ERROR("glGenFramebuffers");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, frameBufferId);
+
+    RETURN_IF_GL_ERROR("glBindFramebuffer");
+
+    glGenTextures(1, &colorTextureId);
+
+    RETURN_IF_GL_ERROR("glGenTextures");
+
+    glBindTexture(GL_TEXTURE_2D, colorTextureId);
+
+    RETURN_IF_GL_ERROR("glBindTexture");
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, screenWidth, screenHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+    RETURN_IF_GL_ERROR("glTexImage2D");
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTextureId, 0);
+
+    GLenum drawBuffers[1] = { GL_COLOR_ATTACHMENT0 };
+
+    glDrawBuffers(1, drawBuffers);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    // Hand the screen back, so the next path starts from the same state.
+    glBindFramebuffer(GL_FRAMEBUFFER, screenFrameBufferId);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return complete;
+}
+
+bool setUploadMode(std::string name)
+{
+    if (name == "subdata")
+    {
+        uploadMode = UPLOAD_SUB_DATA;
+    }
+    else if (name == "ring")
+    {
+        uploadMode = UPLOAD_PERSISTENT_RING;
+    }
+    else if (name == "map")
+    {
+        uploadMode = UPLOAD_MAP_UNSYNCHRONIZED;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+const char* uploadModeName(UploadMode mode)
+{
+    switch (mode)
+    {
+    case UPLOAD_PERSISTENT_RING:
+        return "ring";
+
+    case UPLOAD_MAP_UNSYNCHRONIZED:
+        return "map";
+
+    default:
+        return "subdata";
+    }
+}
+
+bool setVertexFormat(std::string name)
+{
+    if (name == "float")
+    {
+        vertexFormat = VERTEX_FORMAT_FLOAT;
+    }
+    else if (name == "compact")
+    {
+        vertexFormat = VERTEX_FORMAT_COMPACT;
+    }
+    else if (name == "packed")
+    {
+        vertexFormat = VERTEX_FORMAT_PACKED;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+const char* vertexFormatName(VertexFormat format)
+{
+    switch (format)
+    {
+    case VERTEX_FORMAT_COMPACT:
+        return "compact";
+
+    case VERTEX_FORMAT_PACKED:
+        return "packed";
+
+    default:
+        return "float";
+    }
+}
+
+// Bytes per element of the vertex buffer: a vertex, or a whole quad when instanced.
+static GLsizeiptr vertexStride()
+{
+    if (instancedQuads == true)
+    {
+        return sizeof(QuadInstance);
+    }
+
+    switch (vertexFormat)
+    {
+    case VERTEX_FORMAT_COMPACT:
+        return sizeof(CompactVertex);
+
+    case VERTEX_FORMAT_PACKED:
+        return sizeof(PackedVertex);
+
+    default:
+        return sizeof(VertexData3D);
+    }
+}
+
+const void* getQuadData(const Shader& shader)
+{
+    if (getQuadCount(shader) == 0)
+    {
+        return NULL;
+    }
+
+    if (instancedQuads == true)
+    {
+        return &shader.instanceData[0];
+    }
+
+    switch (vertexFormat)
+    {
+    case VERTEX_FORMAT_COMPACT:
+        return &shader.compactVertexData[0];
+
+    case VERTEX_FORMAT_PACKED:
+        return &shader.packedVertexData[0];
+
+    default:
+        return &shader.vertexData[0];
+    }
+}
+
+size_t getBytesPerQuad()
+{
+    return (instancedQuads ? 1 : 4) * vertexStride();
+}
+
+size_t getQuadDataBytes(const Shader& shader)
+{
+    return getQuadCount(shader) * getBytesPerQuad();
+}
+
+// Allocate the shader's range of the arena for capacity vertices, or instances
+// when instanced. The streaming modes hold streamSegmentCount copies back to
+// back, one for each upload in flight.
+static bool createVertexBuffers(Shader& shader, int capacity)
+{
+    int segments = (uploadMode == UPLOAD_SUB_DATA) ? 1 : streamSegmentCount;
+
+    GLsizeiptr vertexBytes = (GLsizeiptr)segments * capacity * vertexStride();
+
+    if (allocateGpuBufferRange(shader.vertexRange, vertexBytes, vertexStride()) == false)
+    {
+        shader.vertexBufferSize = 0;
+
+        return false;
+    }
+
+    shader.vertexBufferSize = capacity;
+
+    // The new range holds nothing yet.
+    for (int i = 0; i < streamSegmentCount; i++)
+    {
+        shader.chunkHashes[i].clear();
+    }
+
+    // The first upload goes to segment 0.
+    shader.streamSegment = streamSegmentCount - 1;
+    shader.baseVertex = shader.vertexRange.offset / vertexStride();
+    shader.vertexBufferOffset = shader.vertexRange.offset;
+
+    return true;
+}
+
+bool initVbo(Shader& shader)
+{
+    if (shader.vertexRange.bufferId == 0)
+    {
+        // glBufferStorage is core in 4.4, otherwise it needs ARB_buffer_storage.
+        if (uploadMode == UPLOAD_PERSISTENT_RING && GLEW_VERSION_4_4 == false && GLEW_ARB_buffer_storage == false)
+        {
+            std::cout << "glBufferStorage not supported, streaming with unsynchronized glMapBufferRange instead" << std::endl;
+
+            uploadMode = UPLOAD_MAP_UNSYNCHRONIZED;
+        }
+
+        // Start with room for 500. updateVbo() grows the range when it becomes necessary.
+        return createVertexBuffers(shader, 500);
+    }
+
+    return true;
+}
+
+// Whether draws can start at an instance other than 0, the base vertex of instances.
+static bool baseInstanceSupported()
+{
+    return GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+}
+
+// Whether draws can read their parameters from a buffer, many in one call.
+static bool multiDrawIndirectSupported()
+{
+    return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+}
+
+// Point the instance attributes at offset in the backing buffer.
+static void setInstanceAttributes(Shader& shader, GLintptr offset)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, shader.vertexRange.bufferId);
+
+    if (shader.instanceCenterLocation != -1)
+    {
+        glVertexAttribPointer(shader.instanceCenterLocation,
+            2,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(QuadInstance),
+            (GLvoid*)(offset + offsetof(QuadInstance, centerX)));
+    }
+
+    if (shader.instanceHalfSizeLocation != -1)
+    {
+        glVertexAttribPointer(shader.instanceHalfSizeLocation,
+            2,
+            GL_SHORT,
+            GL_FALSE,
+            sizeof(QuadInstance),
+            (GLvoid*)(offset + offsetof(QuadInstance, halfWidth)));
+    }
+
+    if (shader.instanceRotationLocation != -1)
+    {
+        glVertexAttribPointer(shader.instanceRotationLocation,
+            1,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(QuadInstance),
+            (GLvoid*)(offset + offsetof(QuadInstance, rotation)));
+    }
+
+    if (shader.instanceScaleLocation != -1)
+    {
+        glVertexAttribPointer(shader.instanceScaleLocation,
+            1,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(QuadInstance),
+            (GLvoid*)(offset + offsetof(QuadInstance, scale)));
+    }
+
+    if (shader.instanceColorLocation != -1)
+    {
+        glVertexAttribPointer(shader.instanceColorLocation,
+            4,
+            GL_UNSIGNED_BYTE,
+            GL_TRUE,
+            sizeof(QuadInstance),
+            (GLvoid*)(offset + offsetof(QuadInstance, color)));
+    }
+
+    shader.instanceAttributeOffset = offset;
+}
+
+// Point the instance attributes at the start of the backing buffer, where the
+// base instance counts from, or without base instances at the instances
+// uploaded at vertexBufferOffset.
+static void setInstanceAttributes(Shader& shader)
+{
+    setInstanceAttributes(shader, baseInstanceSupported() ? 0 : shader.vertexBufferOffset);
+}
+
+// The shader's vec3 position gets z = 0 from the missing third component.
+static void setCompactVertexAttributes(Shader& shader)
+{
+    if (shader.vertexPos2dLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexPos2dLocation,
+            2,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(CompactVertex),
+            (GLvoid*)offsetof(CompactVertex, x));
+    }
+
+    if (shader.vertexTexCoordsLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexTexCoordsLocation,
+            2,
+            GL_HALF_FLOAT,
+            GL_FALSE,
+            sizeof(CompactVertex),
+            (GLvoid*)offsetof(CompactVertex, s));
+    }
+
+    if (shader.vertexColorLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexColorLocation,
+            4,
+            GL_UNSIGNED_BYTE,
+            GL_TRUE,
+            sizeof(CompactVertex),
+            (GLvoid*)offsetof(CompactVertex, color));
+    }
+}
+
+static void setPackedVertexAttributes(Shader& shader)
+{
+    // Not normalized, the shorts are pixels.
+    if (shader.vertexPos2dLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexPos2dLocation,
+            2,
+            GL_SHORT,
+            GL_FALSE,
+            sizeof(PackedVertex),
+            (GLvoid*)offsetof(PackedVertex, x));
+    }
+
+    if (shader.vertexTexCoordsLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexTexCoordsLocation,
+            2,
+            GL_UNSIGNED_SHORT,
+            GL_TRUE,
+            sizeof(PackedVertex),
+            (GLvoid*)offsetof(PackedVertex, s));
+    }
+
+    if (shader.vertexColorLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexColorLocation,
+            4,
+            GL_UNSIGNED_BYTE,
+            GL_TRUE,
+            sizeof(PackedVertex),
+            (GLvoid*)offsetof(PackedVertex, color));
+    }
+}
+
+void setVertexAttributes(Shader& shader)
+{
+    if (instancedQuads == true)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, shader.unitQuadBufferId);
+
+        if (shader.quadCornerLocation != -1)
+        {
+            glVertexAttribPointer(shader.quadCornerLocation, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), NULL);
+        }
+
+        setInstanceAttributes(shader);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBufferId);
+
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, shader.vertexRange.bufferId);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBufferId);
+
+    if (vertexFormat == VERTEX_FORMAT_COMPACT)
+    {
+        setCompactVertexAttributes(shader);
+
+        return;
+    }
+
+    if (vertexFormat == VERTEX_FORMAT_PACKED)
+    {
+        setPackedVertexAttributes(shader);
+
+        return;
+    }
+
+    if (shader.vertexPos2dLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexPos2dLocation,
+            3,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(VertexData3D),
+            (GLvoid*)offsetof(VertexData3D, pos));
+    }
+
+    if (shader.vertexTexCoordsLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexTexCoordsLocation,
+            2,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(VertexData3D),
+            (GLvoid*)offsetof(VertexData3D, texCoords));
+    }
+
+    if (shader.vertexColorLocation != -1)
+    {
+        glVertexAttribPointer(shader.vertexColorLocation,
+            4,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(VertexData3D),
+            (GLvoid*)offsetof(VertexData3D, color));
+    }
+}
+
+// Rewrite a vertex shader written for expanded quads to read instances: its
+// per vertex inputs become globals filled in by expandQuadCorner() before its
+// own main() runs.
+static std::string instanceVertexShader(std::string code)
+{
+    const char* expandedInputs[] = { "in vec3 vertexPos3D;", "in vec2 tex_coords_in;", "in vec4 color_in;" };
+
+    for (int i = 0; i < 3; i++)
+    {
+        size_t position = code.find(expandedInputs[i]);
+
+        if (position != std::string::npos)
+        {
+            code.erase(position, strlen(expandedInputs[i]));
+        }
+    }
+
+    // Right after the #version line, which has to come first.
+    size_t versionEnd = code.find('\n', code.find("#version"));
+
+    code.insert(versionEnd + 1, instancedQuadShaderCode);
+
+    size_t mainPosition = code.find("void main()");
+
+    if (mainPosition != std::string::npos)
+    {
+        code.replace(mainPosition, strlen("void main()"), "void expandedMain()");
+    }
+
+    code += "\nvoid main()\n{\n    expandQuadCorner();\n\n    expandedMain();\n}\n";
+
+    return code;
+}
+
+// The corners of the one quad every instance is drawn from. Its indices are
+// the first quad's in the shared index buffer.
+static bool createUnitQuad(Shader& shader)
+{
+    glGenBuffers(1, &shader.unitQuadBufferId);
+    glBindBuffer(GL_ARRAY_BUFFER, shader.unitQuadBufferId);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(unitQuadCorners), unitQuadCorners, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    RETURN_IF_GL_ERROR2("Error creating unit quad buffer");
+
+    return true;
+}
+
+// Make the shared index buffer cover quadCount quads, up to maxQuadsPerDraw. It
+// only ever grows, in place, so every VAO it is bound to sees the new indices.
+static bool reserveQuadIndices(int quadCount)
+{
+    quadCount = std::min(quadCount, maxQuadsPerDraw);
+
+    if (quadCount <= quadIndexCapacity)
+    {
+        return true;
+    }
+
+    // Double, so a slowly growing scene doesn't rebuild the indices every frame.
+    int capacity = std::min(std::max(quadCount, quadIndexCapacity * 2), maxQuadsPerDraw);
+
+    std::vector<GLushort> indices(capacity * 6);
+
+    for (int i = 0; i < capacity; i++)
+    {
+        GLushort firstVertex = i * 4;
+
+        indices[i * 6 + 0] = firstVertex;
+        indices[i * 6 + 1] = firstVertex + 1;
+        indices[i * 6 + 2] = firstVertex + 2;
+        indices[i * 6 + 3] = firstVertex;
+        indices[i * 6 + 4] = firstVertex + 2;
+        indices[i * 6 + 5] = firstVertex + 3;
+    }
+
+    if (quadIndexBufferId == 0)
+    {
+        glGenBuffers(1, &quadIndexBufferId);
+    }
+
+    GLsizeiptr indexBytes = indices.size() * sizeof(GLushort);
+
+    // Not through GL_ELEMENT_ARRAY_BUFFER, whose binding belongs to the bound VAO.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, quadIndexBufferId);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexBytes, &indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    RETURN_IF_GL_ERROR2("Error creating quad index buffer");
+
+    quadIndexCapacity = capacity;
+
+    uploadStats.bytes += indexBytes;
+
+    return true;
+}
+
+bool initShader(Shader& shader, std::string vertexShaderCode, std::string fragmentShaderCode)
+{
+    if (instancedQuads == true)
+    {
+        vertexShaderCode = instanceVertexShader(vertexShaderCode);
+    }
+
+    shader.programId = createShaders(vertexShaderCode, fragmentShaderCode);
+
+    shader.retained = retainedQuads;
+    shader.vertexUploadFailed = false;
+
+    // Released by freeShader(), which only looks at shaders with a program.
+    if (shader.programId != 0)
+    {
+        quadIndexUsers++;
+    }
+
+    glUseProgram(shader.programId);
+
+    shader.vertexPos2dLocation = glGetAttribLocation(shader.programId, "vertexPos3D");
+    shader.vertexTexCoordsLocation = glGetAttribLocation(shader.programId, "tex_coords_in");
+    shader.vertexColorLocation = glGetAttribLocation(shader.programId, "color_in");
+
+    shader.quadCornerLocation = glGetAttribLocation(shader.programId, "quadCorner");
+    shader.instanceCenterLocation = glGetAttribLocation(shader.programId, "instanceCenter");
+    shader.instanceHalfSizeLocation = glGetAttribLocation(shader.programId, "instanceHalfSize");
+    shader.instanceRotationLocation = glGetAttribLocation(shader.programId, "instanceRotation");
+    shader.instanceScaleLocation = glGetAttribLocation(shader.programId, "instanceScale");
+    shader.instanceColorLocation = glGetAttribLocation(shader.programId, "instanceColor");
+
+    shader.projectionMatrixLocation = glGetUniformLocation(shader.programId, "projectionMatrix");
+    shader.modelViewMatrixLocation = glGetUniformLocation(shader.programId, "modelViewMatrix");
+    shader.texUnitLocation = glGetUniformLocation(shader.programId, "textureUnit");
+
+    // Initialize the projection matrix
+    projectionMatrix = glm::ortho<GLfloat>(0.0, screenWidth, screenHeight, 0.0, 1.0, -1.0);
+    glUniformMatrix4fv(shader.projectionMatrixLocation, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+
+    // The camera's view. recordDrawQuads() sends it again when the camera moves.
+    modelViewMatrix = getCameraViewMatrix();
+    glUniformMatrix4fv(shader.modelViewMatrixLocation, 1, GL_FALSE, glm::value_ptr(modelViewMatrix));
+
+    shader.viewVersion = getCameraVersion();
+
+    if (shader.texUnitLocation != -1)
+    {
+        glUniform1i(shader.texUnitLocation, 0);
+
+        RETURN_IF_GL_ERROR2("Error setting texture location");
+    }
+
+    // Initialize the vertex buffer object and the shared index buffer
+    // that will be used to render the quads.
+    bool vboInitOk = initVbo(shader);
+
+    if (vboInitOk == false) {
+        return false;
+    }
+
+    if (reserveQuadIndices(instancedQuads ? 1 : shader.vertexBufferSize / 4) == false)
+    {
+        return false;
+    }
+
+    if (instancedQuads == true && createUnitQuad(shader) == false)
+    {
+        return false;
+    }
+
+    //Generate textured quad VAO
+    glGenVertexArrays(1, &shader.texturedQuadVao);
+
+    //Bind vertex array
+    glBindVertexArray(shader.texturedQuadVao);
+
+    RETURN_IF_GL_ERROR2("Error binding vertex array");
+
+    // Enable vertex attributes.
+    if (shader.vertexPos2dLocation != -1)
+    {
+        glEnableVertexAttribArray(shader.vertexPos2dLocation);
+
+        RETURN_IF_GL_ERROR2("Error enabling vertex attribute 'Position'");
+    }
+
+    if (shader.vertexTexCoordsLocation != -1)
+    {
+        glEnableVertexAttribArray(shader.vertexTexCoordsLocation);
+
+        RETURN_IF_GL_ERROR2("Error enabling vertex attribute 'Tex Coords'");
+    }
+
+    if (shader.vertexColorLocation != -1)
+    {
+        glEnableVertexAttribArray(shader.vertexColorLocation);
+
+        RETURN_IF_GL_ERROR2("Error enabling vertex attribute 'Color'");
+    }
+
+    if (shader.quadCornerLocation != -1)
+    {
+        glEnableVertexAttribArray(shader.quadCornerLocation);
+
+        RETURN_IF_GL_ERROR2("Error enabling vertex attribute 'Quad Corner'");
+    }
+
+    // Everything else in an instance advances once per quad, not per corner.
+    GLint instanceLocations[] = {
+        shader.instanceCenterLocation,
+        shader.instanceHalfSizeLocation,
+        shader.instanceRotationLocation,
+        shader.instanceScaleLocation,
+        shader.instanceColorLocation
+    };
+
+    for (int i = 0; i < 5; i++)
+    {
+        if (instanceLocations[i] != -1)
+        {
+            glEnableVertexAttribArray(instanceLocations[i]);
+            glVertexAttribDivisor(instanceLocations[i], 1);
+
+            RETURN_IF_GL_ERROR2("Error enabling instance attribute");
+        }
+    }
+
+    //Set vertex data
+    setVertexAttributes(shader);
+
+    RETURN_IF_GL_ERROR2("Error setting vertex data");
+
+    //Unbind VAO
+    glBindVertexArray(0);
+
+    glUseProgram(0);
+
+    return true;
+}
+
+// Wait until the GPU has finished the draws that read a ring segment.
+static void waitForStreamSegment(Shader& shader, int segment)
+{
+    GLsync fence = shader.streamFences[segment];
+
+    if (fence == NULL)
+    {
+        return;
+    }
+
+    // Normally signalled long ago, the GPU is at most two uploads behind.
+    GLenum result = glClientWaitSync(fence, 0, 0);
+
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        uploadStats.fenceWaits++;
+
+        while (result == GL_TIMEOUT_EXPIRED)
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+    }
+
+    glDeleteSync(fence);
+
+    shader.streamFences[segment] = NULL;
+}
+
+void updateVbo(Shader& shader)
+{
+    if (shader.retained == true)
+    {
+        int rangeCount = collectDirtyQuadRanges(shader);
+
+        updateVboRanges(shader, getQuadCount(shader), shader.dirtyRanges.data(), rangeCount);
+
+        return;
+    }
+
+    updateVbo(shader, getQuadData(shader), getQuadCount(shader));
+}
+
+static void deleteStreamFences(Shader& shader)
+{
+    for (int i = 0; i < streamSegmentCount; i++)
+    {
+        if (shader.streamFences[i] != NULL)
+        {
+            glDeleteSync(shader.streamFences[i]);
+
+            shader.streamFences[i] = NULL;
+        }
+    }
+}
+
+// Make room for size vertices (or instances) and their indices. An outgrown
+// range is traded for one twice as big, or of size if that is bigger, so a
+// scene growing a quad at a time only moves now and then. With keepContents
+// the first segment is copied over on the GPU, otherwise it is lost. Leaves no
+// VAO bound. Returns false, keeping the old range, if there is no room.
+static bool reserveVertexBuffers(Shader& shader, int size, bool keepContents)
+{
+    // Re-pointing the attributes below would otherwise change whichever VAO the caller left bound.
+    glBindVertexArray(0);
+
+    // The indices only depend on the quad count, so they are only written when it outgrows them.
+    if (instancedQuads == false && reserveQuadIndices(size / 4) == false)
+    {
+        return false;
+    }
+
+    if (size <= shader.vertexBufferSize)
+    {
+        return true;
+    }
+
+    GpuBufferRange oldRange = shader.vertexRange;
+
+    int oldSize = shader.vertexBufferSize;
+
+    GLsizeiptr oldBytes = (GLsizeiptr)oldSize * vertexStride();
+
+    if (createVertexBuffers(shader, std::max(size, oldSize * 2)) == false)
+    {
+        shader.vertexRange = oldRange;
+        shader.vertexBufferSize = oldSize;
+
+        return false;
+    }
+
+    // They guard the old range's segments, which retire with a fence of their own.
+    deleteStreamFences(shader);
+
+    if (keepContents == true && oldRange.bufferId != 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, oldRange.bufferId);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, shader.vertexRange.bufferId);
+
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldRange.offset, shader.vertexRange.offset, oldBytes);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    GLuint oldBufferId = oldRange.bufferId;
+
+    freeGpuBufferRange(oldRange);
+
+    // Draws find the range by base vertex, so the VAO only changes with the backing buffer.
+    if (shader.vertexRange.bufferId != oldBufferId)
+    {
+        glBindVertexArray(shader.texturedQuadVao);
+
+        setVertexAttributes(shader);
+
+        glBindVertexArray(0);
+    }
+
+    return true;
+}
+
+// Hash bytes of vData in uploadChunkBytes chunks, compare them with what
+// segment was last written with, and call write(offset, bytes) for each run of
+// chunks that changed. Returns the bytes of the unchanged chunks.
+template<typename Write>
+static GLsizeiptr writeChangedChunks(Shader& shader, int segment, const void* vData, GLsizeiptr bytes, const Write& write)
+{
+    std::vector<uint64_t>& hashes = shader.chunkHashes[segment];
+
+    const unsigned char* data = static_cast<const unsigned char*>(vData);
+
+    int chunkCount = (bytes + uploadChunkBytes - 1) / uploadChunkBytes;
+
+    // Chunks the segment has no hash for can't match, and a shorter upload
+    // leaves hashes past its end that no longer describe anything.
+    int knownChunks = std::min<int>(hashes.size(), chunkCount);
+
+    hashes.resize(chunkCount);
+
+    GLsizeiptr skippedBytes = 0;
+
+    int runStart = -1;
+
+    for (int i = 0; i <= chunkCount; i++)
+    {
+        bool changed = false;
+
+        if (i < chunkCount)
+        {
+            GLsizeiptr offset = (GLsizeiptr)i * uploadChunkBytes;
+
+            GLsizeiptr chunkBytes = std::min<GLsizeiptr>(uploadChunkBytes, bytes - offset);
+
+            uint64_t hash = hashBytes(data + offset, chunkBytes);
+
+            changed = (i >= knownChunks || hashes[i] != hash);
+
+            hashes[i] = hash;
+
+            if (changed == false)
+            {
+                skippedBytes += chunkBytes;
+            }
+        }
+
+        if (changed == true && runStart < 0)
+        {
+            runStart = i;
+        }
+        else if (changed == false && runStart >= 0)
+        {
+            GLintptr offset = (GLintptr)runStart * uploadChunkBytes;
+
+            write(offset, std::min<GLsizeiptr>((GLsizeiptr)i * uploadChunkBytes, bytes) - offset);
+
+            runStart = -1;
+        }
+    }
+
+    return skippedBytes;
+}
+
+void updateVbo(Shader& shader, const void* vData, int quadCount)
+{
+    // Update the VBO contents. If the size of the array has increased, allocate a new VBO.
+    // Otherwise update the current VBO with the vertex data for this frame.
+    int size = quadCount * (instancedQuads ? 1 : 4);
+
+    if (size > 0)
+    {
+        PROFILE_SCOPE("updateVbo");
+
+        std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
+
+        if (reserveVertexBuffers(shader, size, false) == false)
+        {
+            std::cout << "updateVbo: no room for " << quadCount << " quads, skipping their upload and draw" << std::endl;
+
+            shader.vertexUploadFailed = true;
+
+            return;
+        }
+
+        shader.vertexUploadFailed = false;
+
+        GLsizeiptr vertexBytes = size * vertexStride();
+
+        GLsizeiptr skippedBytes = 0;
+
+        if (uploadMode == UPLOAD_SUB_DATA)
+        {
+            // Bind vertex buffer.
+            glBindBuffer(GL_ARRAY_BUFFER, shader.vertexRange.bufferId);
+
+            // Update vertex buffer data.
+            if (skipUnchangedUploads == true)
+            {
+                skippedBytes = writeChangedChunks(shader, 0, vData, vertexBytes, [&](GLintptr offset, GLsizeiptr bytes)
+                {
+                    glBufferSubData(GL_ARRAY_BUFFER, shader.vertexRange.offset + offset, bytes, (const char*)vData + offset);
+                });
+            }
+            else
+            {
+                glBufferSubData(GL_ARRAY_BUFFER, shader.vertexRange.offset, vertexBytes, vData);
+            }
+
+            shader.streamSegment = 0;
+        }
+        else
+        {
+            // Each upload takes the next segment, leaving the GPU the ones it may still be reading.
+            int segment = (shader.streamSegment + 1) % streamSegmentCount;
+
+            GLintptr vertexOffset = (GLintptr)segment * shader.vertexBufferSize * vertexStride();
+
+            if (uploadMode == UPLOAD_PERSISTENT_RING && skipUnchangedUploads == true)
+            {
+                // The segment still holds the upload from a full ring ago. A scene
+                // that hasn't changed since doesn't even wait for the GPU.
+                bool waited = false;
+
+                skippedBytes = writeChangedChunks(shader, segment, vData, vertexBytes, [&](GLintptr offset, GLsizeiptr bytes)
+                {
+                    if (waited == false)
+                    {
+                        waitForStreamSegment(shader, segment);
+
+                        waited = true;
+                    }
+
+                    memcpy((char*)shader.vertexRange.mapping + vertexOffset + offset, (const char*)vData + offset, bytes);
+                });
+            }
+            else if (uploadMode == UPLOAD_PERSISTENT_RING)
+            {
+                waitForStreamSegment(shader, segment);
+
+                memcpy((char*)shader.vertexRange.mapping + vertexOffset, vData, vertexBytes);
+            }
+            else
+            {
+                GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+
+                glBindBuffer(GL_ARRAY_BUFFER, shader.vertexRange.bufferId);
+
+                // Orphan on wrap around. The driver hands out fresh storage while the GPU
+                // finishes with the old one, so unsynchronized writes never race a draw.
+                // The range has the backing buffer to itself in this mode.
+                if (segment == 0)
+                {
+                    glBufferData(GL_ARRAY_BUFFER, shader.vertexRange.bytes, NULL, GL_STREAM_DRAW);
+                }
+
+                void* vertexDestination = glMapBufferRange(GL_ARRAY_BUFFER, shader.vertexRange.offset + vertexOffset, vertexBytes, access);
+
+                if (vertexDestination != NULL)
+                {
+                    memcpy(vertexDestination, vData, vertexBytes);
+
+                    glUnmapBuffer(GL_ARRAY_BUFFER);
+                }
+            }
+
+            shader.streamSegment = segment;
+        }
+
+        // Indices count from zero, so point the draw at the segment just written.
+        shader.vertexBufferOffset = shader.vertexRange.offset + (GLintptr)shader.streamSegment * shader.vertexBufferSize * vertexStride();
+        shader.baseVertex = shader.vertexBufferOffset / vertexStride();
+
+        //Unbind buffer
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        std::chrono::duration<double, std::milli> uploadTime = std::chrono::steady_clock::now() - uploadStart;
+
+        uploadStats.bytes += vertexBytes - skippedBytes;
+        uploadStats.skippedBytes += skippedBytes;
+        uploadStats.uploads += (skippedBytes < vertexBytes) ? 1 : 0;
+        uploadStats.milliseconds += uploadTime.count();
+    }
+}
+
+void updateVboRanges(Shader& shader, int quadCount, const QuadRange* ranges, int rangeCount)
+{
+    int size = quadCount * (instancedQuads ? 1 : 4);
+
+    // Nothing changed: no GL calls at all.
+    if (size == 0 || (rangeCount == 0 && size <= shader.vertexBufferSize))
+    {
+        return;
+    }
+
+    PROFILE_SCOPE("updateVbo");
+
+    std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
+
+    // Only the ranges are at hand, so a moved range takes the retained quads
+    // over from the old one on the GPU.
+    if (reserveVertexBuffers(shader, size, true) == false)
+    {
+        std::cout << "updateVboRanges: no room for " << quadCount << " quads, skipping their upload and draw" << std::endl;
+
+        shader.vertexUploadFailed = true;
+
+        return;
+    }
+
+    shader.vertexUploadFailed = false;
+
+    GLsizeiptr quadBytes = getBytesPerQuad();
+
+    GLsizeiptr uploadedBytes = 0;
+
+    // Retained quads stay put in the first segment, ranges are written over them in place.
+    if (uploadMode == UPLOAD_PERSISTENT_RING && rangeCount > 0)
+    {
+        // The last frame's draws may still read what is about to be overwritten.
+        waitForStreamSegment(shader, 0);
+    }
+    else if (uploadMode != UPLOAD_PERSISTENT_RING)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, shader.vertexRange.bufferId);
+    }
+
+    for (int i = 0; i < rangeCount; i++)
+    {
+        GLintptr offset = ranges[i].first * quadBytes;
+        GLsizeiptr bytes = ranges[i].count * quadBytes;
+
+        if (uploadMode == UPLOAD_SUB_DATA)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, shader.vertexRange.offset + offset, bytes, ranges[i].data);
+        }
+        else if (uploadMode == UPLOAD_PERSISTENT_RING)
+        {
+            memcpy((char*)shader.vertexRange.mapping + offset, ranges[i].data, bytes);
+        }
+        else
+        {
+            // Synchronized: the driver waits for, or copies around, draws reading the range.
+            void* destination = glMapBufferRange(GL_ARRAY_BUFFER, shader.vertexRange.offset + offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+
+            if (destination != NULL)
+            {
+                memcpy(destination, ranges[i].data, bytes);
+
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+        }
+
+        uploadedBytes += bytes;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shader.streamSegment = 0;
+    shader.vertexBufferOffset = shader.vertexRange.offset;
+    shader.baseVertex = shader.vertexBufferOffset / vertexStride();
+
+    std::chrono::duration<double, std::milli> uploadTime = std::chrono::steady_clock::now() - uploadStart;
+
+    uploadStats.bytes += uploadedBytes;
+    uploadStats.uploads += (rangeCount > 0) ? 1 : 0;
+    uploadStats.milliseconds += uploadTime.count();
+}
+
+// The ring can't hand the shader's segment out again until the GPU is done with the draws just issued.
+static void fenceStreamSegment(Shader& shader)
+{
+    if (uploadMode == UPLOAD_PERSISTENT_RING)
+    {
+        GLsync& fence = shader.streamFences[shader.streamSegment];
+
+        if (fence != NULL)
+        {
+            glDeleteSync(fence);
+        }
+
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void drawQuads(Shader& shader)
+{
+    drawQuads(shader, getQuadCount(shader));
+}
+
+void drawQuads(Shader& shader, int quadCount)
+{
+    if (quadCount == 0 || shader.vertexUploadFailed == true)
+    {
+        return;
+    }
+
+    beginProfileScope("draw");
+
+    if (instancedQuads == true)
+    {
+        if (baseInstanceSupported() == true)
+        {
+            // The base instance is to instances what the base vertex is to vertices.
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, NULL, quadCount, shader.vertexBufferOffset / sizeof(QuadInstance));
+        }
+        else
+        {
+            // Instance attributes aren't offset by a base vertex, so follow the ring by hand.
+            if (shader.instanceAttributeOffset != shader.vertexBufferOffset)
+            {
+                setInstanceAttributes(shader);
+            }
+
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, NULL, quadCount);
+        }
+    }
+    else
+    {
+        // Every batch reads the same indices, its base vertex picks its quads.
+        for (int firstQuad = 0; firstQuad < quadCount; firstQuad += maxQuadsPerDraw)
+        {
+            int batchQuads = std::min(quadCount - firstQuad, maxQuadsPerDraw);
+
+            glDrawElementsBaseVertex(GL_TRIANGLES, batchQuads * 6, GL_UNSIGNED_SHORT, NULL, shader.baseVertex + firstQuad * 4);
+        }
+    }
+
+    endProfileScope();
+
+    fenceStreamSegment(shader);
+}
+
+// Write the commands into the shader's section of the indirect buffer for the
+// current ring segment, unless it holds them already.
+static void writeDrawCommands(Shader& shader, const std::vector<DrawElementsIndirectCommand>& commands)
+{
+    int commandCount = commands.size();
+
+    if (commandCount > shader.drawCommandCapacity)
+    {
+        shader.drawCommandCapacity = std::max(commandCount, 2 * shader.drawCommandCapacity);
+
+        if (shader.drawCommandBufferId == 0)
+        {
+            glGenBuffers(1, &shader.drawCommandBufferId);
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, shader.drawCommandBufferId);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)streamSegmentCount * shader.drawCommandCapacity * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_DRAW);
+
+        // The new buffer holds nothing yet.
+        for (int i = 0; i < streamSegmentCount; i++)
+        {
+            shader.drawCommands[i].clear();
+        }
+    }
+    else
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, shader.drawCommandBufferId);
+    }
+
+    std::vector<DrawElementsIndirectCommand>& written = shader.drawCommands[shader.streamSegment];
+
+    if (written.size() == commands.size() && memcmp(written.data(), commands.data(), commandCount * sizeof(DrawElementsIndirectCommand)) == 0)
+    {
+        return;
+    }
+
+    GLintptr offset = (GLintptr)shader.streamSegment * shader.drawCommandCapacity * sizeof(DrawElementsIndirectCommand);
+
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, offset, commandCount * sizeof(DrawElementsIndirectCommand), commands.data());
+
+    written = commands;
+}
+
+void drawQuadGroups(Shader& shader, const QuadDrawRange* ranges, int rangeCount)
+{
+    if (rangeCount == 0 || shader.vertexUploadFailed == true)
+    {
+        return;
+    }
+
+    beginProfileScope("draw");
+
+    // One command per range, or per batch of one for non-instanced quads.
+    static std::vector<DrawElementsIndirectCommand> commands;
+
+    commands.clear();
+
+    for (int i = 0; i < rangeCount; i++)
+    {
+        if (instancedQuads == true)
+        {
+            GLuint baseInstance = shader.vertexBufferOffset / sizeof(QuadInstance) + ranges[i].first;
+
+            commands.push_back(DrawElementsIndirectCommand{ 6, (GLuint)ranges[i].count, 0, 0, baseInstance });
+
+            continue;
+        }
+
+        for (int firstQuad = 0; firstQuad < ranges[i].count; firstQuad += maxQuadsPerDraw)
+        {
+            int batchQuads = std::min(ranges[i].count - firstQuad, maxQuadsPerDraw);
+
+            GLint baseVertex = shader.baseVertex + (ranges[i].first + firstQuad) * 4;
+
+            commands.push_back(DrawElementsIndirectCommand{ (GLuint)batchQuads * 6, 1, 0, baseVertex, 0 });
+        }
+    }
+
+    int commandCount = commands.size();
+
+    if (multiDrawIndirectSupported() == true)
+    {
+        writeDrawCommands(shader, commands);
+
+        GLintptr offset = (GLintptr)shader.streamSegment * shader.drawCommandCapacity * sizeof(DrawElementsIndirectCommand);
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (const GLvoid*)offset, commandCount, 0);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else if (instancedQuads == false)
+    {
+        // The same commands, taken apart into the arrays glMultiDrawElementsBaseVertex() wants.
+        static std::vector<GLsizei> counts;
+        static std::vector<const GLvoid*> indices;
+        static std::vector<GLint> baseVertices;
+
+        counts.resize(commandCount);
+        indices.assign(commandCount, NULL);
+        baseVertices.resize(commandCount);
+
+        for (int i = 0; i < commandCount; i++)
+        {
+            counts[i] = commands[i].count;
+            baseVertices[i] = commands[i].baseVertex;
+        }
+
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_SHORT, indices.data(), commandCount, baseVertices.data());
+    }
+    else
+    {
+        for (int i = 0; i < commandCount; i++)
+        {
+            if (baseInstanceSupported() == true)
+            {
+                glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, NULL, commands[i].instanceCount, commands[i].baseInstance);
+            }
+            else
+            {
+                // Each range needs the instance attributes pointed at its first instance.
+                setInstanceAttributes(shader, shader.vertexBufferOffset + (GLintptr)ranges[i].first * sizeof(QuadInstance));
+
+                glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, NULL, commands[i].instanceCount);
+            }
+        }
+    }
+
+    endProfileScope();
+
+    fenceStreamSegment(shader);
+}
+
+void freeVbo(Shader& shader)
+{
+    // Back to the arena, which reuses it once the GPU is done with it.
+    freeGpuBufferRange(shader.vertexRange);
+
+    deleteStreamFences(shader);
+}
+
+void freeVao(Shader& shader)
+{
+    if (shader.texturedQuadVao != 0)
+    {
+        glDeleteVertexArrays(1, &shader.texturedQuadVao);
+
+        shader.texturedQuadVao = 0;
+    }
+}
+
+void freeShader(Shader& shader)
+{
+    freeVbo(shader);
+    freeVao(shader);
+
+    if (shader.unitQuadBufferId != 0)
+    {
+        glDeleteBuffers(1, &shader.unitQuadBufferId);
+
+        shader.unitQuadBufferId = 0;
+    }
+
+    if (shader.drawCommandBufferId != 0)
+    {
+        glDeleteBuffers(1, &shader.drawCommandBufferId);
+
+        shader.drawCommandBufferId = 0;
+        shader.drawCommandCapacity = 0;
+    }
+
+    for (int i = 0; i < streamSegmentCount; i++)
+    {
+        shader.drawCommands[i].clear();
+    }
+
+    if (shader.programId != 0)
+    {
+        quadIndexUsers--;
+
+        if (quadIndexUsers == 0 && quadIndexBufferId != 0)
+        {
+            glDeleteBuffers(1, &quadIndexBufferId);
+
+            quadIndexBufferId = 0;
+            quadIndexCapacity = 0;
+        }
+
+        // The last shader gone, nothing uses the arena's buffers any more.
+        if (quadIndexUsers == 0)
+        {
+            freeGpuBufferArena();
+        }
+
+        glDeleteProgram(shader.programId);
+
+        shader.programId = 0;
+    }
+
+    shader.vertexBufferSize = 0;
+    shader.vertexUploadFailed = false;
+
+    clearQuads(shader);
+}
@@ -0,0 +1,489 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <GL/glu.h>
+
+#include "gpu_buffer_arena.h"
+
+// Alert and return if GL error
+#define RETURN_IF_GL_ERROR(F) RETURN_IF_GL_ERROR2("Function " F " failed with error")
+#define RETURN_IF_GL_ERROR2(M) { GLenum error = glGetError(); if (error != GL_NO_ERROR) { std::cout<< M ": " << gluErrorString(error) << std::endl; return false; } }
+
+extern glm::mat4       projectionMatrix;
+extern glm::mat4       modelViewMatrix;
+
+struct TexCoords
+{
+    GLfloat s;
+    GLfloat t;
+};
+
+struct VertexPos3D
+{
+    GLfloat x;
+    GLfloat y;
+    GLfloat z;
+};
+
+struct ColorRgba
+{
+    GLfloat r;
+    GLfloat g;
+    GLfloat b;
+    GLfloat a;
+};
+
+struct VertexData3D
+{
+    VertexPos3D	pos;
+    TexCoords	texCoords;
+    ColorRgba	color;
+};
+
+// 16 bytes: 2D position, half float tex coords and the RGBA8 group color.
+struct CompactVertex
+{
+    GLfloat     x;
+    GLfloat     y;
+    GLhalf      s;
+    GLhalf      t;
+    GLubyte     color[4];
+};
+
+// 12 bytes: position in whole world units, tex coords as normalized unsigned shorts
+// and the RGBA8 group color.
+struct PackedVertex
+{
+    GLshort     x;
+    GLshort     y;
+    GLushort    s;
+    GLushort    t;
+    GLubyte     color[4];
+};
+
+// Furthest a PackedVertex reaches from the world origin. Corners past it are
+// clamped to it.
+const float packedVertexLimit = 32767.0f;
+
+// Layout of the vertices addQuad() writes when not instanced. The compact ones
+// feed the same shader inputs, the GL widens them to floats.
+enum VertexFormat
+{
+    // VertexData3D, 36 bytes.
+    VERTEX_FORMAT_FLOAT,
+
+    // CompactVertex, 16 bytes.
+    VERTEX_FORMAT_COMPACT,
+
+    // PackedVertex, 12 bytes. Rotated corners snap to whole world units, which
+    // the camera zoom magnifies.
+    VERTEX_FORMAT_PACKED
+};
+
+// Set before initShader().
+extern VertexFormat    vertexFormat;
+
+// One quad of the instanced renderer, 24 bytes against the 4 * 36 bytes of
+// vertices of an expanded quad.
+struct QuadInstance
+{
+    // Center in world units.
+    GLfloat     centerX;
+    GLfloat     centerY;
+
+    // Half size in world units, before scale.
+    GLshort     halfWidth;
+    GLshort     halfHeight;
+
+    // Radians.
+    GLfloat     rotation;
+    GLfloat     scale;
+
+    // Group color, RGBA8.
+    GLubyte     color[4];
+};
+
+// When set, addQuad() appends one QuadInstance instead of four vertices, and
+// the quads are drawn with glDrawElementsInstanced over a unit quad whose
+// corners the vertex shader expands. Set before initShader().
+extern bool            instancedQuads;
+
+// How updateVbo() hands vertex data to the GL.
+enum UploadMode
+{
+    // glBufferSubData into a single VBO, which syncs with the GPU still reading last frame.
+    UPLOAD_SUB_DATA,
+
+    // Persistent coherent mapping (glBufferStorage) of a ring of segments guarded by fences.
+    UPLOAD_PERSISTENT_RING,
+
+    // The same ring written with unsynchronized glMapBufferRange, orphaning the buffer on wrap around.
+    UPLOAD_MAP_UNSYNCHRONIZED
+};
+
+extern UploadMode      uploadMode;
+
+// When set, updateVbo() hashes the vertex data in chunks of uploadChunkBytes
+// and skips the chunks the buffer it writes already holds. Only for modes
+// whose buffers keep their contents: subdata and ring.
+extern bool            skipUnchangedUploads;
+
+const int uploadChunkBytes = 16384;
+
+// Segments in the streaming ring: the CPU fills one while the GPU reads the others.
+const int streamSegmentCount = 3;
+
+// Quads drawn by one call. Their indices come from a static buffer shared by
+// every shader, and 16 bit indices can only address this many quads' vertices.
+const int maxQuadsPerDraw = 16384;
+
+// Leaves elements a vector adds by resize() uninitialized, so sizing a staging
+// vector for a scene doesn't clear memory the scene builders overwrite anyway.
+template<typename T>
+struct DefaultInitAllocator : std::allocator<T>
+{
+    template<typename U>
+    struct rebind
+    {
+        typedef DefaultInitAllocator<U> other;
+    };
+
+    DefaultInitAllocator() = default;
+
+    template<typename U>
+    DefaultInitAllocator(const DefaultInitAllocator<U>&) noexcept {}
+
+    template<typename U>
+    void construct(U* pointer)
+    {
+        ::new ((void*)pointer) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* pointer, Args&&... args)
+    {
+        ::new ((void*)pointer) U(std::forward<Args>(args)...);
+    }
+};
+
+template<typename T>
+using StagingVector = std::vector<T, DefaultInitAllocator<T>>;
+
+// When set, shaders keep their quads uploaded between frames: the driver only
+// builds the scene once, and updateVbo() sends just the quads marked dirty
+// since the last upload (see quad_store.h). Set before initShader().
+extern bool            retainedQuads;
+
+// Quads [first, first + count) of a retained upload, read from data.
+struct QuadRange
+{
+    int             first;
+    int             count;
+    const void*     data;
+};
+
+// An image decoded to tightly packed RGBA8 pixels.
+struct DecodedImage
+{
+    int                         width;
+    int                         height;
+
+    // 1, or more once generateMipmaps() has run.
+    int                         levelCount;
+
+    // Level 0, then each smaller level straight after the one above it.
+    std::vector<unsigned char>  pixels;
+};
+
+// What loading a texture read and made: hashBytes() of the file it came from,
+// and the GPU bytes of every level it was given.
+struct LoadedTextureInfo
+{
+    uint64_t        fileHash;
+    size_t          bytes;
+};
+
+// Quads [first, first + count) of the last upload, drawn as one run.
+struct QuadDrawRange
+{
+    int             first;
+    int             count;
+};
+
+// The layout glMultiDrawElementsIndirect() reads its commands in.
+struct DrawElementsIndirectCommand
+{
+    GLuint          count;
+    GLuint          instanceCount;
+    GLuint          firstIndex;
+    GLint           baseVertex;
+    GLuint          baseInstance;
+};
+
+// A program plus the buffers and vertex array that feed it. Attributes the
+// program doesn't declare have a location of -1 and are skipped.
+struct Shader
+{
+    GLuint                      programId;
+
+    // The shader's range of the GPU buffer arena, holding vertexBufferSize
+    // vertices, or instances when instanced, per ring segment. It grows by
+    // doubling, and only moving to another backing buffer re-points the VAO.
+    GpuBufferRange              vertexRange;
+    int                         vertexBufferSize;
+
+    // Set when the last upload found no room for its quads, so the range
+    // doesn't hold them and draws are skipped until an upload succeeds.
+    bool                        vertexUploadFailed;
+    StagingVector<VertexData3D>     vertexData;
+    StagingVector<CompactVertex>    compactVertexData;
+    StagingVector<PackedVertex>     packedVertexData;
+    StagingVector<QuadInstance>     instanceData;
+    GLuint                      texturedQuadVao;
+
+    // The static unit quad the instanced renderer expands.
+    GLuint                      unitQuadBufferId;
+
+    // Streaming state. The last upload went to streamSegment, and drawQuads() reads it from
+    // baseVertex, or from vertexBufferOffset for instances. Both count from the start of
+    // the backing buffer, not of the shader's range.
+    int                         streamSegment;
+    GLsync                      streamFences[streamSegmentCount];
+    GLint                       baseVertex;
+    GLintptr                    vertexBufferOffset;
+
+    // Hashes of the uploadChunkBytes chunks each segment was last written with.
+    // Emptied when the VBO is replaced.
+    std::vector<uint64_t>       chunkHashes[streamSegmentCount];
+
+    // Offset the VAO's instance attributes currently point at.
+    GLintptr                    instanceAttributeOffset;
+
+    GLint                       vertexPos2dLocation;
+    GLint                       vertexTexCoordsLocation;
+    GLint                       vertexColorLocation;
+    GLint                       quadCornerLocation;
+    GLint                       instanceCenterLocation;
+    GLint                       instanceHalfSizeLocation;
+    GLint                       instanceRotationLocation;
+    GLint                       instanceScaleLocation;
+    GLint                       instanceColorLocation;
+    GLint                       projectionMatrixLocation;
+    GLint                       modelViewMatrixLocation;
+
+    // Camera version the program's modelViewMatrix was last recorded with.
+    uint32_t                    viewVersion;
+    GLint                       texUnitLocation;
+
+    // Retained mode state. Quads below uploadedQuadCount are in the VBO already,
+    // and only those listed in dirtyQuads (flagged in quadDirty) changed since.
+    // dirtyRanges holds the ranges the last updateVbo() sent.
+    bool                        retained;
+    int                         uploadedQuadCount;
+    std::vector<uint8_t>        quadDirty;
+    std::vector<int>            dirtyQuads;
+    std::vector<QuadRange>      dirtyRanges;
+
+    // Group draw state (see quad_groups.h). groupStarts holds the first quad of
+    // each group added since clearQuads(). Hidden groups and the draw order
+    // outlive it, so they hold while the scene is rebuilt every frame.
+    // groupDrawRanges is what the last collectQuadGroupDrawRanges() built.
+    std::vector<int>            groupStarts;
+    std::vector<uint8_t>        groupHidden;
+    std::vector<int>            groupDrawOrder;
+    std::vector<QuadDrawRange>  groupDrawRanges;
+
+    // Indirect draw commands: a section of drawCommandCapacity commands per ring
+    // segment, and the commands last written to each, so unchanged ones aren't
+    // sent again.
+    GLuint                      drawCommandBufferId;
+    int                         drawCommandCapacity;
+    std::vector<DrawElementsIndirectCommand>    drawCommands[streamSegmentCount];
+};
+
+struct Vertex2
+{
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+// One square quad, as passed to addSquareQuad().
+struct QuadParams
+{
+    float   x;
+    float   y;
+    float   rotationDegrees;
+    float   scale;
+    bool    newGroup;
+};
+
+// When set, render paths build this scene instead of their hardcoded quads.
+extern const std::vector<QuadParams>* benchmarkScene;
+
+// The shader a render path built benchmarkScene into, for the benchmark to
+// change the scene's quads and groups after it is built.
+extern Shader*         benchmarkSceneShader;
+
+// Bytes handed to the GL by updateVbo() and the CPU time it took, since the last reset.
+struct UploadStats
+{
+    uint64_t    bytes;
+    uint64_t    uploads;
+    double      milliseconds;
+
+    // Times the persistent ring had to wait for the GPU to release a segment.
+    uint64_t    fenceWaits;
+
+    // Bytes not handed over because the buffer already held them.
+    uint64_t    skippedBytes;
+};
+
+extern UploadStats     uploadStats;
+
+// When set, addQuad() and addScene() drop the quads whose rotated bounding box
+// misses what the camera shows, so they are neither stored nor uploaded. The quads kept
+// are packed together. writeQuad() writes wherever it is told.
+extern bool            viewportCulling;
+
+// Quads the culling kept and dropped, since the last reset.
+struct CullStats
+{
+    uint64_t    visibleQuads;
+    uint64_t    culledQuads;
+};
+
+extern CullStats       cullStats;
+
+// Color of the current quad group, advanced by addQuad() when a new group starts.
+extern ColorRgba       groupColor;
+
+extern uint32_t        colorCounter;
+
+// From a counter value derive a color visually distinct to the human eye
+// compared to the other colors nearby in the permutation.
+uint32_t getGroupColor(uint32_t counter);
+
+void resetGroupColor(ColorRgba color);
+
+// Reference transform of a single quad; addQuad() and addScene() use transformQuadCorners().
+void rotatePoints(float rotationAngle, const std::vector<Vertex2>& pointsToRotate, std::vector<Vertex2>& rotatedPoints, Vertex2 originTranslation);
+
+// Append a w x h quad centered at world point (x, y), rotated about its own
+// center. Quads are stored in world units, and the camera (see camera.h) places
+// them on the screen.
+void addQuad(Shader& shader, float x, float y, float w, float h, float rotationDegrees, bool newGroup);
+
+// Append a square quad, 50 pixels per unit of scale.
+void addSquareQuad(Shader& shader, float x, float y, float rotationDegrees, float scale, bool newGroup);
+
+// Append the scene's quads. Blocks of quads are built in parallel by jobs (see
+// job_system.h), each into its own slice of the staging vector, and
+// colored from their group index, so the result matches adding them one by one.
+void addScene(Shader& shader, const std::vector<QuadParams>& quads);
+
+// Quads added since the last clearQuads(), in either mode.
+int getQuadCount(const Shader& shader);
+
+// The vertices (or instances) addQuad() wrote, in the current format, and
+// their size. NULL when there are none.
+const void* getQuadData(const Shader& shader);
+
+size_t getQuadDataBytes(const Shader& shader);
+
+// Bytes one quad takes in the VBO: four vertices, or one instance.
+size_t getBytesPerQuad();
+
+// Size the staging vector to quadCount quads. New quads are uninitialized
+// until written, removed ones are dropped from the end.
+void resizeQuads(Shader& shader, int quadCount);
+
+// Write a w x h quad centered at world point (x, y) over quad
+// quadIndex, which must exist, and mark it dirty.
+void writeQuad(Shader& shader, int quadIndex, float x, float y, float w, float h, float rotationDegrees, ColorRgba color);
+
+// Copy quad from over quad to, and mark to dirty.
+void moveQuad(Shader& shader, int from, int to);
+
+void clearQuads(Shader& shader);
+
+bool loadBufferIntoTexture(GLint* buffer, size_t size, int width, int height, GLuint& textureId);
+
+bool initImageLoader();
+
+// Read a PNG file and decode it to RGBA8, rows in the order glTexImage2D()
+// takes them. Safe to call from any thread: decodes take turns, since DevIL
+// has one bound image for the process. With fileHash, the file's bytes are
+// hashed as well, while they are in memory.
+bool decodeImageFile(std::string filename, DecodedImage& image, uint64_t* fileHash = NULL);
+
+// Nearest filtering and border clamping, for the GL_TEXTURE_2D bound, with
+// trilinear minification when it has levelCount levels.
+void setImageTextureParameters(int levelCount);
+
+// Decode filename into a new texture, bound to texture unit level while it is
+// uploaded. With bakedTextures, a baked copy of it is loaded instead, and
+// with textureMipmaps, its mip chain is generated and uploaded. Fills info,
+// when given, from what was loaded.
+bool loadImageIntoTexture(std::string filename, GLuint& textureId, uint32_t level, LoadedTextureInfo* info = NULL);
+
+GLuint createShaders(std::string vertexShaderCode, std::string fragmentShaderCode);
+
+// Compile the program, look up its attributes and uniforms, and create its VBO and VAO.
+// With instancedQuads the vertex shader's vertexPos3D, tex_coords_in and color_in inputs are
+// replaced by values expanded from the instance, so the same shader serves both modes.
+bool initShader(Shader& shader, std::string vertexShaderCode, std::string fragmentShaderCode);
+
+bool initFbo(GLuint& frameBufferId, GLuint& colorTextureId);
+
+// Select the upload mode by name: subdata, ring or map. Returns false for an unknown name.
+bool setUploadMode(std::string name);
+
+const char* uploadModeName(UploadMode mode);
+
+// Select the vertex format by name: float, compact or packed. Returns false for an unknown name.
+bool setVertexFormat(std::string name);
+
+const char* vertexFormatName(VertexFormat format);
+
+bool initVbo(Shader& shader);
+
+// Upload the shader's quads. Retained shaders only upload their dirty ranges.
+void updateVbo(Shader& shader);
+
+// Upload quadCount quads' vertices (or instances) from vData instead of the shader's
+// staging vectors, e.g. a copy the render thread was handed.
+void updateVbo(Shader& shader, const void* vData, int quadCount);
+
+// Write rangeCount ranges of a retained shader's quads into the VBO in place,
+// keeping the rest, which now holds quadCount quads. When quadCount outgrows
+// the shader's range, the quads already uploaded are copied to the new one on
+// the GPU.
+void updateVboRanges(Shader& shader, int quadCount, const QuadRange* ranges, int rangeCount);
+
+// Draw everything the last updateVbo() uploaded. Expects the shader's program and VAO bound.
+void drawQuads(Shader& shader);
+
+// Draw the first quadCount quads of the last upload.
+void drawQuads(Shader& shader, int quadCount);
+
+// Draw rangeCount runs of the last upload, in order, with one
+// glMultiDrawElementsIndirect() where the GL has it. Expects the shader's
+// program and VAO bound.
+void drawQuadGroups(Shader& shader, const QuadDrawRange* ranges, int rangeCount);
+
+void freeVbo(Shader& shader);
+
+void freeVao(Shader& shader);
+
+void freeShader(Shader& shader);
@@ -0,0 +1,466 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "asset_pack.h"
+#include "baked_texture.h"
+#include "mipmaps.h"
+#include "render_thread.h"
+#include "testbed.h"
+#include "texture_cache.h"
+#include "texture_loader.h"
+
+struct CachedTexture
+{
+    // 0 for a free slot, or one merged into another.
+    GLuint                      textureId;
+
+    // A file read from disk isn't hashed, or its bytes known, until it loads.
+    bool                        hashed;
+    uint64_t                    hash;
+    size_t                      bytes;
+
+    int                         references;
+
+    // useCounter when the texture was last acquired, bound or released.
+    uint64_t                    lastUse;
+
+    // Every path acquired for it, so evicting it forgets them all.
+    std::vector<std::string>    paths;
+
+    // The slot whose texture this one's load turned out to duplicate, or -1.
+    // A merged slot has no texture or paths of its own, and only lives on to
+    // forward the handles still naming it.
+    int                         mergedInto;
+};
+
+size_t          textureCacheBudgetBytes = 256 << 20;
+
+static std::vector<CachedTexture>               slots;
+static std::vector<uint8_t>                     slotGenerations;
+static std::vector<uint32_t>                    freeSlots;
+
+static std::unordered_map<std::string, uint32_t> pathSlots;
+static std::unordered_map<uint64_t, uint32_t>   hashSlots;
+
+static uint64_t                                 useCounter = 0;
+
+static size_t                                   cachedBytes = 0;
+
+static int                                      cachedCount = 0;
+static int                                      evictionCount = 0;
+
+static uint32_t handleSlot(TextureHandle handle)
+{
+    return handle & 0x00FFFFFF;
+}
+
+static uint8_t handleGeneration(TextureHandle handle)
+{
+    return handle >> 24;
+}
+
+static TextureHandle makeTextureHandle(uint32_t slot, uint8_t generation)
+{
+    return ((TextureHandle)generation << 24) | slot;
+}
+
+// The slot of a live handle, merged or not, or -1.
+static int findSlot(TextureHandle handle)
+{
+    uint32_t slot = handleSlot(handle);
+
+    if (handle == invalidTextureHandle || slot >= slots.size() || slotGenerations[slot] != handleGeneration(handle))
+    {
+        return -1;
+    }
+
+    if (slots[slot].textureId == 0 && slots[slot].mergedInto < 0)
+    {
+        return -1;
+    }
+
+    return slot;
+}
+
+static uint32_t readBigEndian32(const unsigned char* bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+// GPU bytes of the texture a file loads into: the baked levels, or a PNG's
+// size from its IHDR chunk, which the loaders expand to RGBA8 and, with
+// textureMipmaps, a mip chain.
+static size_t getTextureFileBytes(const AssetSpan& span, bool baked)
+{
+    if (baked == true)
+    {
+        return getBakedTextureBytes(span.data, span.bytes);
+    }
+
+    static const unsigned char pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    if (span.bytes < 24 || memcmp(span.data, pngSignature, 8) != 0 || memcmp(span.data + 12, "IHDR", 4) != 0)
+    {
+        return 0;
+    }
+
+    int width = readBigEndian32(span.data + 16);
+    int height = readBigEndian32(span.data + 20);
+
+    if (textureMipmaps == true)
+    {
+        return getMipChainBytes(width, height, getMipLevelCount(width, height));
+    }
+
+    return (size_t)width * height * 4;
+}
+
+static void deleteTextureCall(void* data)
+{
+    GLuint textureId = (GLuint)(uintptr_t)data;
+
+    glDeleteTextures(1, &textureId);
+}
+
+// Recorded, so frames already recorded with the texture bound draw before it
+// goes, and its name isn't reused under them.
+static void deleteTexture(GLuint textureId)
+{
+    if (textureId != 0)
+    {
+        recordCall(deleteTextureCall, (void*)(uintptr_t)textureId);
+    }
+}
+
+// Make slot free, so the handles naming it go stale.
+static void freeSlot(uint32_t slot)
+{
+    CachedTexture& texture = slots[slot];
+
+    texture.textureId = 0;
+    texture.hashed = false;
+    texture.paths.clear();
+    texture.mergedInto = -1;
+
+    slotGenerations[slot]++;
+
+    freeSlots.push_back(slot);
+}
+
+static void evictSlot(uint32_t slot)
+{
+    CachedTexture& texture = slots[slot];
+
+    // It may still be waiting for its image.
+    cancelTextureLoads(texture.textureId);
+
+    deleteTexture(texture.textureId);
+
+    for (size_t i = 0; i < texture.paths.size(); i++)
+    {
+        pathSlots.erase(texture.paths[i]);
+    }
+
+    if (texture.hashed == true)
+    {
+        hashSlots.erase(texture.hash);
+    }
+
+    cachedBytes -= texture.bytes;
+    cachedCount--;
+
+    freeSlot(slot);
+}
+
+// Hand slot's paths and references to into, which already has the same
+// texture, and delete its own.
+static void mergeSlot(uint32_t slot, uint32_t into)
+{
+    CachedTexture& texture = slots[slot];
+    CachedTexture& target = slots[into];
+
+    deleteTexture(texture.textureId);
+
+    texture.textureId = 0;
+
+    for (size_t i = 0; i < texture.paths.size(); i++)
+    {
+        pathSlots[texture.paths[i]] = into;
+
+        target.paths.push_back(texture.paths[i]);
+    }
+
+    texture.paths.clear();
+
+    target.references += texture.references;
+    target.lastUse = ++useCounter;
+
+    cachedBytes -= texture.bytes;
+    cachedCount--;
+
+    texture.bytes = 0;
+    texture.mergedInto = into;
+
+    if (texture.references == 0)
+    {
+        freeSlot(slot);
+    }
+}
+
+void trimTextureCache()
+{
+    while (cachedBytes > textureCacheBudgetBytes)
+    {
+        int oldest = -1;
+
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            if (slots[i].textureId != 0 && slots[i].references == 0 && (oldest < 0 || slots[i].lastUse < slots[oldest].lastUse))
+            {
+                oldest = i;
+            }
+        }
+
+        // Everything left is referenced.
+        if (oldest < 0)
+        {
+            return;
+        }
+
+        evictSlot(oldest);
+
+        evictionCount++;
+    }
+}
+
+// Take a reference to the texture in slot, known by path from now on.
+static TextureHandle referenceSlot(uint32_t slot, const std::string& path)
+{
+    CachedTexture& texture = slots[slot];
+
+    if (pathSlots.insert(std::make_pair(path, slot)).second == true)
+    {
+        texture.paths.push_back(path);
+    }
+
+    texture.references++;
+    texture.lastUse = ++useCounter;
+
+    return makeTextureHandle(slot, slotGenerations[slot]);
+}
+
+// The load of a file from disk has finished, on the main thread: count its
+// bytes, and merge it into the texture already cached with the same hash.
+static void textureLoaded(void* data, const LoadedTextureInfo& info)
+{
+    int slot = findSlot((TextureHandle)(uintptr_t)data);
+
+    // Evicting a texture cancels its load, so this is only a safeguard.
+    if (slot < 0 || slots[slot].mergedInto >= 0)
+    {
+        return;
+    }
+
+    std::unordered_map<uint64_t, uint32_t>::iterator byHash = hashSlots.find(info.fileHash);
+
+    if (byHash != hashSlots.end())
+    {
+        mergeSlot(slot, byHash->second);
+
+        return;
+    }
+
+    CachedTexture& texture = slots[slot];
+
+    texture.hashed = true;
+    texture.hash = info.fileHash;
+
+    hashSlots[texture.hash] = slot;
+
+    // Nothing was counted for it until now.
+    texture.bytes = info.bytes;
+
+    cachedBytes += texture.bytes;
+
+    trimTextureCache();
+}
+
+TextureHandle acquireTexture(std::string filename)
+{
+    std::unordered_map<std::string, uint32_t>::iterator byPath = pathSlots.find(filename);
+
+    if (byPath != pathSlots.end())
+    {
+        return referenceSlot(byPath->second, filename);
+    }
+
+    // The bytes the texture will load from: the baked copy if it is used.
+    bool baked = bakedTextureAvailable(filename);
+
+    std::string sourceFilename = (baked == true) ? getBakedTexturePath(filename) : filename;
+
+    // A packed file's hash is in the pack's index, so a duplicate is found
+    // before anything loads. A file on disk is hashed by the load that reads
+    // it, and merged once that finishes.
+    uint64_t hash = 0;
+    size_t bytes = 0;
+
+    AssetSpan span;
+
+    bool packed = (findAssetHash(sourceFilename, hash) == true && findAsset(sourceFilename, span) == true);
+
+    if (packed == true)
+    {
+        std::unordered_map<uint64_t, uint32_t>::iterator byHash = hashSlots.find(hash);
+
+        if (byHash != hashSlots.end())
+        {
+            return referenceSlot(byHash->second, filename);
+        }
+
+        // Only reads the header, from the mapping.
+        bytes = getTextureFileBytes(span, baked);
+    }
+    else if (assetExists(sourceFilename) == false)
+    {
+        std::cout << "Failed to open texture file " << sourceFilename << std::endl;
+
+        return invalidTextureHandle;
+    }
+
+    uint32_t slot;
+
+    if (freeSlots.empty() == false)
+    {
+        slot = freeSlots.back();
+
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slot = slots.size();
+
+        slots.push_back(CachedTexture());
+        slotGenerations.push_back(0);
+    }
+
+    CachedTexture& texture = slots[slot];
+
+    texture.textureId = 0;
+    texture.hashed = packed;
+    texture.hash = hash;
+    texture.bytes = bytes;
+    texture.references = 0;
+    texture.paths.clear();
+    texture.mergedInto = -1;
+
+    if (packed == true)
+    {
+        hashSlots[hash] = slot;
+    }
+
+    cachedBytes += bytes;
+    cachedCount++;
+
+    TextureHandle handle = referenceSlot(slot, filename);
+
+    // Referenced first, since textureLoaded() may merge it before this returns.
+    if (loadImageIntoTextureAsync(filename, texture.textureId, 0, (packed == true) ? NULL : textureLoaded, (void*)(uintptr_t)handle) == false)
+    {
+        evictSlot(slot);
+
+        return invalidTextureHandle;
+    }
+
+    // The new texture is referenced, so only older ones can make room for it.
+    trimTextureCache();
+
+    return handle;
+}
+
+void releaseTexture(TextureHandle handle)
+{
+    int slot = findSlot(handle);
+
+    if (slot < 0 || slots[slot].references == 0)
+    {
+        return;
+    }
+
+    slots[slot].references--;
+    slots[slot].lastUse = ++useCounter;
+
+    int target = slots[slot].mergedInto;
+
+    if (target >= 0)
+    {
+        slots[target].references--;
+        slots[target].lastUse = ++useCounter;
+
+        if (slots[slot].references == 0)
+        {
+            freeSlot(slot);
+        }
+    }
+
+    trimTextureCache();
+}
+
+GLuint getTextureId(TextureHandle handle)
+{
+    int slot = findSlot(handle);
+
+    if (slot < 0)
+    {
+        return 0;
+    }
+
+    if (slots[slot].mergedInto >= 0)
+    {
+        slot = slots[slot].mergedInto;
+    }
+
+    slots[slot].lastUse = ++useCounter;
+
+    return slots[slot].textureId;
+}
+
+void freeTextureCache()
+{
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        if (slots[i].textureId != 0)
+        {
+            evictSlot(i);
+        }
+    }
+
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        if (slots[i].mergedInto >= 0)
+        {
+            freeSlot(i);
+        }
+    }
+}
+
+size_t getTextureCacheBytes()
+{
+    return cachedBytes;
+}
+
+int getTextureCacheCount()
+{
+    return cachedCount;
+}
+
+int getTextureCacheEvictions()
+{
+    return evictionCount;
+}
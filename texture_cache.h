@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <GL/glew.h>
+
+// Names a cached texture while it is referenced: a slot index in the low 24
+// bits, and in the high 8 the slot's generation, which evicting the texture
+// bumps so old handles stop matching.
+typedef uint32_t TextureHandle;
+
+const TextureHandle invalidTextureHandle = 0xFFFFFFFF;
+
+// GPU bytes the cache keeps textures in before it evicts unreferenced ones.
+// Referenced textures are never evicted, so they may take it over budget.
+extern size_t          textureCacheBudgetBytes;
+
+// A reference to the texture of filename, loading it unless the same path, or
+// another file with the same bytes, is already loaded. A packed file's hash
+// comes from the pack's index. A file on disk is hashed by the load that
+// reads it, and if it turns out to have the same bytes as a cached texture,
+// its handles are given that texture once callTextureLoadedFunctions() hears
+// it has loaded. Loads go through
+// loadImageIntoTextureAsync(), so they may show a placeholder at first. May
+// evict unreferenced textures to stay within budget. Returns
+// invalidTextureHandle when the file can't be loaded. Call where the context is.
+TextureHandle acquireTexture(std::string filename);
+
+// Drop a reference. A texture nobody references stays loaded for
+// acquireTexture() to hand out again, until the budget needs its bytes; the
+// least recently used goes first. Call where the context is.
+void releaseTexture(TextureHandle handle);
+
+// The texture to bind, 0 for a stale handle. Counts as a use for eviction order.
+// Like the rest of the cache, only for the main thread. Textures it deletes go
+// through recordCall(), so a name recorded for a frame stays valid until that
+// frame has run.
+GLuint getTextureId(TextureHandle handle);
+
+// Evict unreferenced textures, least recently used first, until the cache is
+// within budget. Call where the context is.
+void trimTextureCache();
+
+// Delete every cached texture. Handles still held become stale. Call where the
+// context is.
+void freeTextureCache();
+
+// GPU bytes of the cached textures, referenced or not. A file from disk counts
+// once its load finishes.
+size_t getTextureCacheBytes();
+
+int getTextureCacheCount();
+
+// Textures evicted since the start.
+int getTextureCacheEvictions();
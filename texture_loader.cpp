@@ -0,0 +1,404 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/glu.h>
+
+#include "baked_texture.h"
+#include "mipmaps.h"
+#include "render_thread.h"
+#include "testbed.h"
+#include "texture_loader.h"
+
+// Every load has its own serial. GL hands a deleted texture's name to the
+// next one, so the name alone can't tell a cancelled load from a new one.
+struct TextureLoad
+{
+    uint64_t        serial;
+    std::string     filename;
+    GLuint          textureId;
+    uint32_t        level;
+
+    TextureLoadedFunction   loaded;
+    void*           loadedData;
+};
+
+struct DecodedTexture
+{
+    uint64_t        serial;
+    GLuint          textureId;
+    uint32_t        level;
+    bool            decoded;
+    DecodedImage    image;
+
+    TextureLoadedFunction   loaded;
+    void*           loadedData;
+
+    // Only hashed when loaded is set.
+    uint64_t        fileHash;
+};
+
+bool            asyncTextureLoading = false;
+
+static std::vector<std::thread>     loaderThreads;
+
+// Guards everything below it. Loader threads wait on loadQueued, the context's
+// thread on loadDecoded.
+static std::mutex                   loaderMutex;
+static std::condition_variable      loadQueued;
+static std::condition_variable      loadDecoded;
+
+static std::deque<TextureLoad>      queuedLoads;
+static std::deque<DecodedTexture>   decodedLoads;
+
+struct PendingTextureLoad
+{
+    uint64_t        serial;
+    GLuint          textureId;
+};
+
+// Every load not yet uploaded. A cancelled load is missing from it, so its
+// image is dropped once decoded.
+static std::vector<PendingTextureLoad>  pendingTextures;
+
+struct FinishedTextureLoad
+{
+    TextureLoadedFunction   loaded;
+    void*                   loadedData;
+    LoadedTextureInfo       info;
+};
+
+// Uploaded loads whose loaded function the main thread has yet to call.
+static std::vector<FinishedTextureLoad> finishedLoads;
+
+static uint64_t                     nextLoadSerial = 1;
+
+static bool                         loaderStopping = false;
+
+// Only touched where the context is.
+static GLuint                       unpackBufferId = 0;
+
+static void loaderMain()
+{
+    while (true)
+    {
+        TextureLoad load;
+
+        {
+            std::unique_lock<std::mutex> lock(loaderMutex);
+
+            loadQueued.wait(lock, [] { return queuedLoads.empty() == false || loaderStopping == true; });
+
+            if (loaderStopping == true)
+            {
+                return;
+            }
+
+            load = std::move(queuedLoads.front());
+
+            queuedLoads.pop_front();
+        }
+
+        DecodedTexture decoded;
+
+        decoded.serial = load.serial;
+        decoded.textureId = load.textureId;
+        decoded.level = load.level;
+        decoded.loaded = load.loaded;
+        decoded.loadedData = load.loadedData;
+        decoded.fileHash = 0;
+        decoded.decoded = decodeImageFile(load.filename, decoded.image, (load.loaded != NULL) ? &decoded.fileHash : NULL);
+
+        // Loader threads aren't job threads, so the chain is filtered here alone.
+        if (decoded.decoded == true && textureMipmaps == true)
+        {
+            generateMipmaps(decoded.image, false);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+
+            decodedLoads.push_back(std::move(decoded));
+        }
+
+        loadDecoded.notify_all();
+    }
+}
+
+void initTextureLoader()
+{
+    shutdownTextureLoader();
+
+    loaderStopping = false;
+
+    for (int i = 0; i < textureLoaderThreadCount; i++)
+    {
+        loaderThreads.push_back(std::thread(loaderMain));
+    }
+}
+
+void shutdownTextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+
+        loaderStopping = true;
+    }
+
+    loadQueued.notify_all();
+
+    for (size_t i = 0; i < loaderThreads.size(); i++)
+    {
+        loaderThreads[i].join();
+    }
+
+    loaderThreads.clear();
+
+    queuedLoads.clear();
+    decodedLoads.clear();
+    pendingTextures.clear();
+    finishedLoads.clear();
+
+    if (unpackBufferId != 0)
+    {
+        glDeleteBuffers(1, &unpackBufferId);
+
+        unpackBufferId = 0;
+    }
+}
+
+bool loadImageIntoTextureAsync(std::string filename, GLuint& textureId, uint32_t level, TextureLoadedFunction loaded, void* loadedData)
+{
+    // A baked texture has nothing to decode, so it isn't worth a loader thread.
+    if (asyncTextureLoading == false || loaderThreads.empty() == true || bakedTextureAvailable(filename) == true)
+    {
+        LoadedTextureInfo info;
+
+        if (loadImageIntoTexture(filename, textureId, level, (loaded != NULL) ? &info : NULL) == false)
+        {
+            return false;
+        }
+
+        if (loaded != NULL)
+        {
+            loaded(loadedData, info);
+        }
+
+        return true;
+    }
+
+    glGenTextures(1, &textureId);
+
+    RETURN_IF_GL_ERROR("glGenTextures");
+
+    glActiveTexture(GL_TEXTURE0 + level);
+
+    glBindTexture(GL_TEXTURE_2D, textureId);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureLoadPlaceholder);
+
+    setImageTextureParameters(1);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    RETURN_IF_GL_ERROR("glTexImage2D");
+
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+
+        uint64_t serial = nextLoadSerial++;
+
+        queuedLoads.push_back(TextureLoad{ serial, filename, textureId, level, loaded, loadedData });
+
+        pendingTextures.push_back(PendingTextureLoad{ serial, textureId });
+    }
+
+    loadQueued.notify_one();
+
+    return true;
+}
+
+void cancelTextureLoads(GLuint textureId)
+{
+    std::lock_guard<std::mutex> lock(loaderMutex);
+
+    // Loads already taken by a loader thread are dropped when they come back.
+    queuedLoads.erase(std::remove_if(queuedLoads.begin(), queuedLoads.end(), [=](const TextureLoad& load) { return load.textureId == textureId; }), queuedLoads.end());
+
+    pendingTextures.erase(std::remove_if(pendingTextures.begin(), pendingTextures.end(), [=](const PendingTextureLoad& pending) { return pending.textureId == textureId; }), pendingTextures.end());
+}
+
+static void uploadDecodedTexture(const DecodedTexture& decoded)
+{
+    const DecodedImage& image = decoded.image;
+
+    GLsizeiptr bytes = image.pixels.size();
+
+    if (unpackBufferId == 0)
+    {
+        glGenBuffers(1, &unpackBufferId);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBufferId);
+
+    // Orphaned for every image, so the copy in never waits for the GPU to finish reading the last one.
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+
+    void* mapping = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+    if (mapping != NULL)
+    {
+        memcpy(mapping, image.pixels.data(), bytes);
+
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    glActiveTexture(GL_TEXTURE0 + decoded.level);
+
+    glBindTexture(GL_TEXTURE_2D, decoded.textureId);
+
+    for (int i = 0; i < image.levelCount; i++)
+    {
+        size_t offset = getMipLevelOffset(image.width, image.height, i);
+
+        // With the buffer bound, the pixels argument is an offset into it.
+        const void* pixels = (mapping != NULL) ? (const void*)offset : image.pixels.data() + offset;
+
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, getMipLevelSize(image.width, i), getMipLevelSize(image.height, i), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+
+    // The placeholder had one level.
+    setImageTextureParameters(image.levelCount);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    GLenum error = glGetError();
+
+    if (error != GL_NO_ERROR)
+    {
+        std::cout << "Error uploading loaded texture: " << gluErrorString(error) << std::endl;
+    }
+}
+
+void updateTextureLoads()
+{
+    size_t uploadedBytes = 0;
+
+    while (true)
+    {
+        DecodedTexture decoded;
+
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex);
+
+            if (decodedLoads.empty() == true)
+            {
+                return;
+            }
+
+            if (uploadedBytes > 0 && uploadedBytes + decodedLoads.front().image.pixels.size() > textureUploadBytesPerFrame)
+            {
+                return;
+            }
+
+            decoded = std::move(decodedLoads.front());
+
+            decodedLoads.pop_front();
+
+            uint64_t serial = decoded.serial;
+
+            std::vector<PendingTextureLoad>::iterator pending = std::find_if(pendingTextures.begin(), pendingTextures.end(), [=](const PendingTextureLoad& load) { return load.serial == serial; });
+
+            if (pending == pendingTextures.end())
+            {
+                continue;
+            }
+
+            pendingTextures.erase(pending);
+        }
+
+        uploadedBytes += decoded.image.pixels.size();
+
+        // A failed decode has said why; the texture keeps its placeholder.
+        if (decoded.decoded == true)
+        {
+            uploadDecodedTexture(decoded);
+
+            // The owner's bookkeeping is the main thread's, which this may not be.
+            if (decoded.loaded != NULL)
+            {
+                std::lock_guard<std::mutex> lock(loaderMutex);
+
+                finishedLoads.push_back(FinishedTextureLoad{ decoded.loaded, decoded.loadedData, LoadedTextureInfo{ decoded.fileHash, decoded.image.pixels.size() } });
+            }
+        }
+    }
+}
+
+static void updateTextureLoadsCall(void*)
+{
+    updateTextureLoads();
+}
+
+void recordUpdateTextureLoads()
+{
+    recordCall(updateTextureLoadsCall, NULL);
+}
+
+void callTextureLoadedFunctions()
+{
+    std::vector<FinishedTextureLoad> finished;
+
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+
+        if (finishedLoads.empty() == true)
+        {
+            return;
+        }
+
+        finished.swap(finishedLoads);
+    }
+
+    for (size_t i = 0; i < finished.size(); i++)
+    {
+        finished[i].loaded(finished[i].loadedData, finished[i].info);
+    }
+}
+
+void finishTextureLoads()
+{
+    while (getPendingTextureLoadCount() > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock(loaderMutex);
+
+            loadDecoded.wait(lock, [] { return decodedLoads.empty() == false || pendingTextures.empty() == true; });
+        }
+
+        updateTextureLoads();
+    }
+
+    callTextureLoadedFunctions();
+}
+
+int getPendingTextureLoadCount()
+{
+    std::lock_guard<std::mutex> lock(loaderMutex);
+
+    return pendingTextures.size();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+
+#include <GL/glew.h>
+
+struct LoadedTextureInfo;
+
+// Threads that read and decode images for loadImageIntoTextureAsync().
+const int textureLoaderThreadCount = 2;
+
+// Decoded bytes updateTextureLoads() uploads in one call. A bigger image
+// still goes, on its own, so every load finishes.
+const size_t textureUploadBytesPerFrame = 8 << 20;
+
+// The RGBA8 color a texture shows until its image arrives.
+const GLubyte textureLoadPlaceholder[4] = { 255, 0, 255, 255 };
+
+// When set, render paths load their images with loadImageIntoTextureAsync(),
+// so initializing a path no longer waits for files to be read and decoded.
+extern bool            asyncTextureLoading;
+
+// Start and stop the decode threads. Loads still queued are dropped.
+void initTextureLoader();
+
+void shutdownTextureLoader();
+
+// Called on the main thread once a load's texture holds its image, with the
+// data given to loadImageIntoTextureAsync().
+typedef void (*TextureLoadedFunction)(void* data, const LoadedTextureInfo& info);
+
+// Create textureId at once, holding a 1x1 placeholder, and queue filename to
+// be read and decoded on a loader thread. updateTextureLoads() later replaces
+// the placeholder with the image, in the same texture, so the id can be bound
+// meanwhile. Without asyncTextureLoading, or for a baked texture, this is
+// loadImageIntoTexture(). Either way, loaded is called once the image is in
+// the texture: before this returns if it loaded at once, else from
+// callTextureLoadedFunctions(). The file is hashed for it where it is read.
+// Call where the context is.
+bool loadImageIntoTextureAsync(std::string filename, GLuint& textureId, uint32_t level, TextureLoadedFunction loaded = NULL, void* loadedData = NULL);
+
+// Forget the loads queued for textureId, before the texture is deleted.
+void cancelTextureLoads(GLuint textureId);
+
+// Upload the images decoded so far, up to textureUploadBytesPerFrame, through
+// a pixel unpack buffer, so glTexImage2D() returns without copying the pixels.
+// Call where the context is, once a frame.
+void updateTextureLoads();
+
+// updateTextureLoads() where the context is.
+void recordUpdateTextureLoads();
+
+// Call the loaded function of every load updateTextureLoads() has uploaded
+// since. Call on the main thread, at the start of a frame, since a render
+// thread may be uploading.
+void callTextureLoadedFunctions();
+
+// Wait for every queued load, upload it and call its loaded function. Call
+// on the main thread, where the context is.
+void finishTextureLoads();
+
+// Loads queued or decoded but not yet uploaded.
+int getPendingTextureLoadCount();